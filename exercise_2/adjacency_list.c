@@ -2,7 +2,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
-#include <string.h>
 
 /**
  * @brief returns the vertex with the given id from the given list
@@ -11,26 +10,52 @@
  * @return NULL if the list does not contain a vertex with the given id, the vertex node with the given id otherwise
  */
 static vertex_node_t* get_vertex_node(adjacency_list_t *list, int vertex) {
-	int i;
-	for(i = 0; i < list->length; i++){
-		if(list->vertices[i].id == vertex){
-			return &list->vertices[i];
+	long index = vertex_map_get(list->map, vertex);
+	return index == -1 ? NULL : &list->vertices[index];
+}
+
+/**
+ * @brief doubles the size of the vertices array of the given list if it is full
+ * @param list the list
+ * @return 0 on success, -1 if a memory allocation error occured
+ */
+static int reserve_vertex(adjacency_list_t *list) {
+	if(list->length + 1 > list->size){
+		list->size = list->size * 2;
+		vertex_node_t *reallocated = realloc(list->vertices, list->size * sizeof(vertex_node_t));
+		if(reallocated == NULL){
+			list->size = list->size / 2;
+			perror("adjecency_list: Memory allocation error occured.");
+			return -1;
 		}
+		list->vertices = reallocated;
 	}
-	return NULL;
+	return 0;
 }
 
-adjacency_list_t* create_list(void){
-	int default_size = 2;
+/**
+ * @brief creates an empty list that can hold the given number of vertices without growing
+ * @param size the number of vertices the vertices array can hold
+ * @param expected_vertices the number of vertices the map can hold without growing
+ * @return NULL if a memory allocation error occured, the list otherwise
+ */
+static adjacency_list_t* create_list_with_size(size_t size, size_t expected_vertices){
 	adjacency_list_t *list = malloc(sizeof(adjacency_list_t));
 	if(list == NULL){
 		perror("adjecency_list: Memory allocation error occured.");
 		return NULL;
 	}
-	list->size = default_size;
+	list->size = size;
 	list->length = 0;
+	list->edge_block = NULL;
+	list->edge_block_length = 0;
 	list->vertices = malloc(list->size * sizeof(vertex_node_t));
-	if(list->vertices == NULL){
+	list->map = create_vertex_map(expected_vertices);
+	if(list->vertices == NULL || list->map == NULL){
+		free(list->vertices);
+		if(list->map != NULL){
+			free_vertex_map(list->map);
+		}
 		free(list);
 		perror("adjecency_list: Memory allocation error occured.");
 		return NULL;
@@ -38,34 +63,87 @@ adjacency_list_t* create_list(void){
 	return list;
 }
 
+adjacency_list_t* create_list(void){
+	return create_list_with_size(2, 2);
+}
+
+/**
+ * @brief returns the index of the vertex with the given id and adds the vertex if the list does not contain it
+ * @details looks the vertex up with a single probe sequence of the map.
+ * @param list the list
+ * @param vertex the id of the vertex
+ * @return the index of the vertex or -1 if a memory allocation error occured
+ */
+static long find_or_add_vertex(adjacency_list_t *list, int vertex) {
+	//the map assigns the index list->length to a new vertex, so there has to be room for it
+	if(reserve_vertex(list) == -1){
+		return -1;
+	}
+	long index = vertex_map_insert(list->map, vertex);
+	if(index == (long)list->length){
+		list->vertices[list->length].next = NULL;
+		list->vertices[list->length].id = vertex;
+		list->length = list->length + 1;
+	}
+	return index;
+}
+
+adjacency_list_t* create_list_from_edges(const edge_t *edges, size_t count) {
+	size_t i;
+	//the edges have at most 2 * count distinct vertices, so the vertices array never grows. Its pages are only
+	//touched for the vertices that exist. The map is initialized completely, so it is sized for count vertices,
+	//which is enough unless the graph has more vertices than edges
+	adjacency_list_t *list = create_list_with_size(count > 0 ? 2 * count : 2, count > 0 ? count : 2);
+	if(list == NULL){
+		return NULL;
+	}
+	list->edge_block = malloc(count * sizeof(vertex_node_t) + 1);
+	if(list->edge_block == NULL){
+		free_list_memory(list);
+		perror("adjecency_list: Memory allocation error occured.");
+		return NULL;
+	}
+	list->edge_block_length = count;
+	for(i = 0; i < count; i++){
+		long source = find_or_add_vertex(list, edges[i].source);
+		if(source == -1 || find_or_add_vertex(list, edges[i].destination) == -1){
+			//the nodes of the edges that were not added yet are not linked
+			list->edge_block_length = i;
+			free_list_memory(list);
+			return NULL;
+		}
+		vertex_node_t *vertex = &list->vertices[source];
+		vertex_node_t *edge_node = &list->edge_block[i];
+		edge_node->id = edges[i].destination;
+		edge_node->next = vertex->next;
+		vertex->next = edge_node;
+	}
+	//the edge nodes only point to each other, so the vertices can be moved
+	if(list->length > 0 && list->length < list->size){
+		vertex_node_t *shrunk = realloc(list->vertices, list->length * sizeof(vertex_node_t));
+		if(shrunk != NULL){
+			list->vertices = shrunk;
+			list->size = list->length;
+		}
+	}
+	return list;
+}
+
 bool contains(adjacency_list_t *list, int vertex) {
 	return index_of(list,vertex) != -1;
 }
 
 int index_of(adjacency_list_t* list, int vertex) {
-	int i;
-	for(i = 0; i < list->length; i++){
-		if(list->vertices[i].id == vertex){
-			return i;
-		}
-	}
-	return -1;
+	return vertex_map_get(list->map, vertex);
 }
 
 int add_vertex(adjacency_list_t *list, int vertex) {
 	if(contains(list, vertex)){
 		return 1;
 	}
-	//increase the size of the vertices array if necessary
-	if(list->length + 1 > list->size){
-		list->size = list->size * 2;
-		vertex_node_t *reallocated = realloc(list->vertices, list->size * sizeof(vertex_node_t));
-		if(reallocated == NULL){
-			list->size = list->size / 2;
-			perror("adjecency_list: Memory allocation error occured.");
-			return -1;
-		}
-		list->vertices = reallocated;
+	//increase the size of the vertices array if necessary, before the vertex is added to the map
+	if(reserve_vertex(list) == -1 || vertex_map_insert(list->map, vertex) == -1){
+		return -1;
 	}
 	//add the vertex	
 	list->vertices[list->length].next = NULL;
@@ -94,48 +172,39 @@ int add_edge(adjacency_list_t *list, int source_vertex, int destination_vertex){
 
 void free_list_memory(adjacency_list_t *list) {
 	int i;
-	//free the edge lists
+	//free the edge lists, the nodes in the edge block are freed at once. A list without an edge block has none of
+	//its nodes in it, and the bounds of the block are only computed if it exists
 	for(i = 0; i < list->length; i++){
 		while(list->vertices[i].next != NULL){
-			vertex_node_t *next = list->vertices[i].next->next;
-			free(list->vertices[i].next);
+			vertex_node_t *node = list->vertices[i].next;
+			vertex_node_t *next = node->next;
+			bool in_block = list->edge_block != NULL && node >= list->edge_block &&
+					node < list->edge_block + list->edge_block_length;
+			if(!in_block){
+				free(node);
+			}
 			list->vertices[i].next = next;
 		}
 	}
 	//free vertices array
+	free(list->edge_block);
 	free(list->vertices);
+	free_vertex_map(list->map);
 	free(list);
 }
 
-char* get_edges_string(adjacency_list_t *list) {
-	int i, size = 4, buffSize = 100;
-	char buff[100];
-	char *str = malloc(size);
-	if(str == NULL){
-		perror("adjecency_list: Memory allocation error occured.");
-		return NULL;
-	}
-	str[0] = '\0';
-	
+size_t get_edges(adjacency_list_t *list, edge_t *edges, size_t max_edges) {
+	size_t i, count = 0;
 	for(i = 0; i < list->length; i++){
 		vertex_node_t *next = list->vertices[i].next;
 		while(next != NULL) {
-			snprintf(buff, buffSize, "%d-%d ", list->vertices[i].id, next->id);
-			if(strlen(str) + strlen(buff) + 1 > size){
-				//size is not large enough, increase the size and loop again
-				size = size * 2;
-				char *reallocated = realloc(str, size);
-				if(reallocated == NULL){
-					free(str);
-					perror("adjecency_list: Memory allocation error occured.");
-					return NULL;
-				}
-				str = reallocated;
-			}else{
-				strcat(str,buff);
-				next = next->next;
+			if(count < max_edges){
+				edges[count].source = list->vertices[i].id;
+				edges[count].destination = next->id;
 			}
+			count++;
+			next = next->next;
 		}
 	}
-	return str;
+	return count;
 }
@@ -10,6 +10,8 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include "edge.h"
+#include "vertex_map.h"
 
 /**
  * @brief represents a vertex in the graph. Stores the edges that originate from the vertex.
@@ -28,11 +30,17 @@ typedef struct vertex_node {
  *         the length property represents the length of the list of vertices
  *         the size property represents the maximum number of vertices that can be stored in the list with the currently 
  *         allocated memory
+ *         the map property maps the id of every vertex to its index in the vertices array, so looking up a vertex is O(1)
+ *         the edge_block property holds edge_block_length edge nodes that were allocated at once by
+ *         create_list_from_edges, or is NULL. Edge nodes that were added by add_edge are allocated individually.
  */
 typedef struct adjacency_list {
 	vertex_node_t *vertices;
 	size_t length;
 	size_t size;
+	vertex_map_t *map;
+	vertex_node_t *edge_block;
+	size_t edge_block_length;
 } adjacency_list_t;
 
 
@@ -42,6 +50,21 @@ typedef struct adjacency_list {
  */
 adjacency_list_t* create_list(void);
 
+/**
+ * @brief creates a list that contains the given edges and their vertices
+ * @details builds the list in one pass over the edges. The vertices are added in the order in which they first
+ *          appear in the edges and all edge nodes are allocated in one block, so the result is the same as adding
+ *          the source and the destination of every edge with add_vertex and then the edge with add_edge, but
+ *          without an allocation per edge. The vertices array is sized for the at most 2 * count vertices of the
+ *          edges up front and shrunk to the actual number of vertices afterwards, the vertex map is sized for count
+ *          vertices, so neither of them grows while the list is built unless the graph has more vertices than
+ *          edges. Further vertices and edges can be added to the list afterwards.
+ * @param edges the edges of the graph
+ * @param count the number of edges
+ * @return NULL if a memory allocation error occured, the list otherwise
+ */
+adjacency_list_t* create_list_from_edges(const edge_t *edges, size_t count);
+
 /**
  * @brief checks whether the given list contains a vertex with the given id
  * @param list the list that the vertex should be searched in
@@ -84,10 +107,15 @@ int index_of(adjacency_list_t* list, int vertex);
 int add_edge(adjacency_list_t* list, int source_vertex, int destination_vertex);
 
 /**
- * @brief returns a string representation of the edges in the graph
- * @return NULL if a memory allocation error occured, the string representation of the graph otherwise
+ * @brief writes the edges of the graph into the given edge array
+ * @details writes at most max_edges edges of the graph into the given array. The edges are not formatted in any way,
+ *          so that they can be copied into the shared memory directly.
+ * @param list the list whose edges should be written into the array
+ * @param edges the array that the edges should be written into, has to be able to hold max_edges edges
+ * @param max_edges the maximum number of edges that should be written into the array
+ * @return the number of edges in the graph, which may be larger than max_edges
  */
-char* get_edges_string(adjacency_list_t* list);
+size_t get_edges(adjacency_list_t* list, edge_t *edges, size_t max_edges);
 
 /**
  * @brief frees all of the dynamically allocated memory of the given list.
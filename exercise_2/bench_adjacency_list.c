@@ -0,0 +1,322 @@
+/**
+ * @file
+ * @brief bench_adjacency_list module compares incremental and bulk construction of adjacency lists with the
+ *        construction by linear scans that the adjacency list used before it had a vertex map
+ *
+ * @autor Benjamin Deutsch (12215881)
+ * @date 16.11.2023
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "adjacency_list.h"
+#include "rng.h"
+
+#define DEFAULT_LINEAR_SCAN_EDGES 20000 //the default number of edges the quadratic linear scan baseline is built from
+
+/**
+ * @brief an adjacency list whose vertices are found by a linear scan, as before the list had a vertex map
+ * @details the vertices array starts with 2 vertices and doubles, every edge node is allocated on its own.
+ */
+typedef struct linear_list {
+	vertex_node_t *vertices;
+	size_t length;
+	size_t size;
+} linear_list_t;
+
+/**
+ * @brief prints the usage message for the benchmark
+ */
+static void print_usage_message(void) {
+	fprintf(stderr, "USAGE: bench_adjacency_list [-v vertices] [-e edges] [-l edges]\n");
+}
+
+/**
+ * @brief returns the seconds elapsed since the given point in time
+ * @param start the point in time
+ * @return the elapsed seconds
+ */
+static double seconds_since(const struct timespec *start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief returns the index of the vertex with the given id by scanning all vertices of the given list
+ * @param list the list
+ * @param vertex the id of the vertex
+ * @return the index of the vertex or -1 if the list does not contain it
+ */
+static long linear_index_of(const linear_list_t *list, int vertex) {
+	size_t i;
+	for(i = 0; i < list->length; i++){
+		if(list->vertices[i].id == vertex){
+			return i;
+		}
+	}
+	return -1;
+}
+
+/**
+ * @brief adds the vertex with the given id to the given list if it does not contain it yet
+ * @param list the list
+ * @param vertex the id of the vertex
+ * @return 0 on success, -1 if a memory allocation error occured
+ */
+static int linear_add_vertex(linear_list_t *list, int vertex) {
+	if(linear_index_of(list, vertex) != -1){
+		return 0;
+	}
+	if(list->length == list->size){
+		size_t size = list->size * 2;
+		vertex_node_t *reallocated = realloc(list->vertices, size * sizeof(vertex_node_t));
+		if(reallocated == NULL){
+			return -1;
+		}
+		list->vertices = reallocated;
+		list->size = size;
+	}
+	list->vertices[list->length].id = vertex;
+	list->vertices[list->length].next = NULL;
+	list->length++;
+	return 0;
+}
+
+/**
+ * @brief adds the given edge to the given list, checking both vertices with linear scans like add_edge used to
+ * @param list the list
+ * @param source the id of the source vertex
+ * @param destination the id of the destination vertex
+ * @return 0 on success, -1 if a memory allocation error occured
+ */
+static int linear_add_edge(linear_list_t *list, int source, int destination) {
+	if(linear_index_of(list, source) == -1 || linear_index_of(list, destination) == -1){
+		return 0;
+	}
+	vertex_node_t *edge_node = malloc(sizeof(vertex_node_t));
+	if(edge_node == NULL){
+		return -1;
+	}
+	vertex_node_t *vertex = &list->vertices[linear_index_of(list, source)];
+	edge_node->id = destination;
+	edge_node->next = vertex->next;
+	vertex->next = edge_node;
+	return 0;
+}
+
+/**
+ * @brief frees the vertices and edge nodes of the given list
+ * @param list the list
+ */
+static void free_linear_list(linear_list_t *list) {
+	size_t i;
+	for(i = 0; i < list->length; i++){
+		while(list->vertices[i].next != NULL){
+			vertex_node_t *next = list->vertices[i].next->next;
+			free(list->vertices[i].next);
+			list->vertices[i].next = next;
+		}
+	}
+	free(list->vertices);
+}
+
+/**
+ * @brief builds a list by linear scans, adding the vertices and edges one at a time
+ * @param list the list that should be built, it is freed if an error occurs
+ * @param edges the edges
+ * @param count the number of edges
+ * @return 0 on success, -1 if a memory allocation error occured
+ */
+static int build_linear_scan(linear_list_t *list, const edge_t *edges, size_t count) {
+	size_t i;
+	list->length = 0;
+	list->size = 2;
+	list->vertices = malloc(list->size * sizeof(vertex_node_t));
+	if(list->vertices == NULL){
+		return -1;
+	}
+	for(i = 0; i < count; i++){
+		if(linear_add_vertex(list, edges[i].source) == -1 || linear_add_vertex(list, edges[i].destination) == -1 ||
+				linear_add_edge(list, edges[i].source, edges[i].destination) == -1){
+			free_linear_list(list);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief writes the edges of the given linear scan list in the order of get_edges
+ * @param list the list
+ * @param edges the buffer, it has to hold all edges of the list
+ * @return the number of edges
+ */
+static size_t get_linear_edges(const linear_list_t *list, edge_t *edges) {
+	size_t i, count = 0;
+	for(i = 0; i < list->length; i++){
+		const vertex_node_t *next;
+		for(next = list->vertices[i].next; next != NULL; next = next->next){
+			edges[count].source = list->vertices[i].id;
+			edges[count].destination = next->id;
+			count++;
+		}
+	}
+	return count;
+}
+
+/**
+ * @brief builds a list by adding the vertices and edges one at a time
+ * @param edges the edges
+ * @param count the number of edges
+ * @return the list or NULL if a memory allocation error occured
+ */
+static adjacency_list_t* build_incrementally(const edge_t *edges, size_t count) {
+	size_t i;
+	adjacency_list_t *list = create_list();
+	for(i = 0; i < count && list != NULL; i++){
+		if(add_vertex(list, edges[i].source) == -1 || add_vertex(list, edges[i].destination) == -1 ||
+				add_edge(list, edges[i].source, edges[i].destination) == -1){
+			free_list_memory(list);
+			list = NULL;
+		}
+	}
+	return list;
+}
+
+/**
+ * @brief measures the construction of an adjacency list from random edges with add_vertex and add_edge and with
+ *        create_list_from_edges, and checks that both lists contain the same edges
+ * @details incremental construction with add_vertex and add_edge looks the vertices up in the vertex map, so it
+ *          is no longer quadratic. The quadratic construction by linear scans is measured as a baseline on the
+ *          first edges only, together with both other constructions of the same edges.
+ * @param argc the number of arguments
+ * @param argv can contain the following arguments:
+ *             -v [int]: the number of vertices, 100000 by default
+ *             -e [int]: the number of edges, 1000000 by default
+ *             -l [int]: the number of edges the linear scan baseline is built from, DEFAULT_LINEAR_SCAN_EDGES by
+ *                       default, at most the number of edges. 0 skips the baseline
+ * @return EXIT_SUCCESS if the benchmark executed successfully, EXIT_FAILURE otherwise
+ */
+int main(int argc, char *argv[]) {
+	int c;
+	long vertices = 100000, edge_count = 1000000, linear_count = DEFAULT_LINEAR_SCAN_EDGES;
+	while((c = getopt(argc, argv, "v:e:l:")) != -1){
+		switch(c) {
+			case 'v':
+				if(sscanf(optarg, "%ld", &vertices) != 1 || vertices < 1){
+					print_usage_message();
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'e':
+				if(sscanf(optarg, "%ld", &edge_count) != 1 || edge_count < 1){
+					print_usage_message();
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'l':
+				if(sscanf(optarg, "%ld", &linear_count) != 1 || linear_count < 0){
+					print_usage_message();
+					return EXIT_FAILURE;
+				}
+				break;
+			default:
+				print_usage_message();
+				return EXIT_FAILURE;
+		}
+	}
+
+	edge_t *edges = malloc(edge_count * sizeof(edge_t));
+	edge_t *incremental_edges = malloc(edge_count * sizeof(edge_t));
+	edge_t *bulk_edges = malloc(edge_count * sizeof(edge_t));
+	if(edges == NULL || incremental_edges == NULL || bulk_edges == NULL){
+		free(edges);
+		free(incremental_edges);
+		free(bulk_edges);
+		perror("bench_adjacency_list: Memory allocation error");
+		return EXIT_FAILURE;
+	}
+	rng_t rng;
+	rng_seed(&rng, 12215881);
+	long i;
+	for(i = 0; i < edge_count; i++){
+		edges[i].source = rng_bounded(&rng, vertices);
+		edges[i].destination = rng_bounded(&rng, vertices);
+	}
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	adjacency_list_t *incremental = build_incrementally(edges, edge_count);
+	double incremental_seconds = seconds_since(&start);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	adjacency_list_t *bulk = create_list_from_edges(edges, edge_count);
+	double bulk_seconds = seconds_since(&start);
+
+	bool error = incremental == NULL || bulk == NULL;
+	if(!error){
+		size_t incremental_count = get_edges(incremental, incremental_edges, edge_count);
+		size_t bulk_count = get_edges(bulk, bulk_edges, edge_count);
+		error = incremental_count != bulk_count || incremental->length != bulk->length ||
+				memcmp(incremental_edges, bulk_edges, bulk_count * sizeof(edge_t)) != 0;
+		if(error){
+			fprintf(stderr, "bench_adjacency_list: The lists differ\n");
+		}else{
+			printf("%ld vertices, %ld edges: incremental %.3f s, bulk %.3f s\n", (long)bulk->length, edge_count,
+					incremental_seconds, bulk_seconds);
+		}
+	}
+	if(incremental != NULL){
+		free_list_memory(incremental);
+	}
+	if(bulk != NULL){
+		free_list_memory(bulk);
+	}
+
+	//the baseline is quadratic, so it is built from the first edges only, and so are the lists it is compared to
+	if(linear_count > edge_count){
+		linear_count = edge_count;
+	}
+	if(!error && linear_count > 0){
+		linear_list_t linear;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		bool built = build_linear_scan(&linear, edges, linear_count) == 0;
+		double linear_seconds = seconds_since(&start);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		incremental = build_incrementally(edges, linear_count);
+		incremental_seconds = seconds_since(&start);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		bulk = create_list_from_edges(edges, linear_count);
+		bulk_seconds = seconds_since(&start);
+		if(!built || incremental == NULL || bulk == NULL){
+			perror("bench_adjacency_list: Memory allocation error");
+			error = true;
+		}else{
+			size_t linear_edges = get_linear_edges(&linear, incremental_edges);
+			size_t bulk_count = get_edges(bulk, bulk_edges, linear_count);
+			error = linear_edges != bulk_count || linear.length != bulk->length ||
+					memcmp(incremental_edges, bulk_edges, bulk_count * sizeof(edge_t)) != 0;
+			if(error){
+				fprintf(stderr, "bench_adjacency_list: The lists differ\n");
+			}else{
+				printf("first %ld edges, %ld vertices: linear scan %.3f s, incremental %.3f s, bulk %.3f s\n",
+						linear_count, (long)bulk->length, linear_seconds, incremental_seconds, bulk_seconds);
+			}
+		}
+		if(built){
+			free_linear_list(&linear);
+		}
+		if(incremental != NULL){
+			free_list_memory(incremental);
+		}
+		if(bulk != NULL){
+			free_list_memory(bulk);
+		}
+	}
+	free(edges);
+	free(incremental_edges);
+	free(bulk_edges);
+	return error ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file
+ * @brief bench_buffer module measures the throughput of the shared solution buffer between processes
+ *
+ * @autor Benjamin Deutsch (12215881)
+ * @date 16.11.2023
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "shared_buffer.h"
+
+/**
+ * @brief prints the usage message for the benchmark
+ */
+static void print_usage_message(void) {
+	fprintf(stderr, "USAGE: bench_buffer [-p producers] [-n records] [-e max_edges]\n");
+}
+
+/**
+ * @brief pins the calling process to the given cpu, modulo the number of available cpus
+ * @details pinning is best effort, the benchmark still runs if it fails.
+ * @param cpu the cpu
+ */
+static void pin_to_cpu(int cpu) {
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpus > 0 ? cpu % cpus : 0, &set);
+	sched_setaffinity(0, sizeof(set), &set);
+}
+
+/**
+ * @brief writes the given number of records into the shared buffer
+ * @param producer the number of the producer, which determines its cpu
+ * @param records the number of records
+ * @param max_edges the largest number of edges of a record
+ * @return EXIT_SUCCESS if all records were written, EXIT_FAILURE otherwise
+ */
+static int run_producer(int producer, long records, size_t max_edges) {
+	pin_to_cpu(producer + 1);
+	size_t shared_size;
+	int shmfd = init_shared_memory(&shared_size);
+	if(shmfd == -1){
+		return EXIT_FAILURE;
+	}
+	shared_data_t *shared_data = mmap(NULL, shared_size, PROT_READ | PROT_WRITE, MAP_SHARED, shmfd, 0);
+	close(shmfd);
+	solution_t *solution = create_solution(max_edges);
+	if(shared_data == MAP_FAILED || solution == NULL){
+		return EXIT_FAILURE;
+	}
+	size_t e;
+	for(e = 0; e < max_edges; e++){
+		solution->edges[e].source = e;
+		solution->edges[e].destination = e + 1;
+	}
+	solution->kind = SOLUTION_SAMPLE;
+	solution->generator = getpid();
+	long i;
+	for(i = 0; i < records; i++){
+		solution->size = 1 + i % max_edges;
+		if(write_solution(shared_data, solution)){
+			break;
+		}
+	}
+	free(solution);
+	munmap(shared_data, shared_size);
+	close_semaphores();
+	return i == records ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief measures how fast solutions can be passed from generator processes to the supervisor
+ * @details creates the shared memory, forks the producers and reads all of their records in the parent process.
+ *          The reader and every producer are pinned to different cpus, so the positions and records have to move
+ *          between the caches of the cores. The throughput of the cache line aligned layout can be compared to a
+ *          packed layout by running the bench_buffer_packed binary, which is built with a smaller
+ *          SHARED_BUFFER_ALIGNMENT. Must not be run while a supervisor is running.
+ * @param argc the number of arguments
+ * @param argv can contain the following arguments:
+ *             -p [int]: the number of producer processes, 1 by default
+ *             -n [int]: the number of records every producer writes, 1000000 by default
+ *             -e [int]: the largest number of edges of a record, 4 by default
+ * @return EXIT_SUCCESS if the benchmark executed successfully, EXIT_FAILURE otherwise
+ */
+int main(int argc, char *argv[]) {
+	int c, producers = 1, max_edges = 4;
+	long records = 1000000;
+	while((c = getopt(argc, argv, "p:n:e:")) != -1){
+		switch(c) {
+			case 'p':
+				if(sscanf(optarg, "%d", &producers) != 1 || producers < 1){
+					print_usage_message();
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'n':
+				if(sscanf(optarg, "%ld", &records) != 1 || records < 1){
+					print_usage_message();
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'e':
+				if(sscanf(optarg, "%d", &max_edges) != 1 || max_edges < 1){
+					print_usage_message();
+					return EXIT_FAILURE;
+				}
+				break;
+			default:
+				print_usage_message();
+				return EXIT_FAILURE;
+		}
+	}
+
+	pin_to_cpu(0);
+	size_t shared_size;
+	int shmfd = create_shared_memory(DEFAULT_BUFFER_CAPACITY, &shared_size);
+	if(shmfd == -1){
+		return EXIT_FAILURE;
+	}
+	shared_data_t *shared_data = mmap(NULL, shared_size, PROT_READ | PROT_WRITE, MAP_SHARED, shmfd, 0);
+	close(shmfd);
+	solution_t *solution = NULL;
+	bool error = shared_data == MAP_FAILED;
+	if(!error){
+		solution = create_solution(get_max_solution_size(shared_data));
+		error = solution == NULL || (size_t)max_edges > get_max_solution_size(shared_data);
+	}
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int i;
+	for(i = 0; i < producers && !error; i++){
+		pid_t pid = fork();
+		if(pid == 0){
+			exit(run_producer(i, records, max_edges));
+		}
+		error = pid == -1;
+	}
+	long read;
+	for(read = 0; read < producers * records && !error; read++){
+		error = read_solution(shared_data, solution) == -1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	if(!error){
+		double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+		printf("alignment %d bytes, %d producers: %ld records in %.3f s, %.1f ns per record, %.0f records/s\n",
+				SHARED_BUFFER_ALIGNMENT, producers, read, seconds, seconds * 1e9 / read, read / seconds);
+	}
+	if(shared_data != MAP_FAILED){
+		shared_data->quit = true;
+		release_waiting_processes();
+	}
+	while(wait(NULL) > 0);
+	free(solution);
+	if(shared_data != MAP_FAILED){
+		munmap(shared_data, shared_size);
+	}
+	unlink_shared_memory();
+	unlink_semaphores();
+	close_semaphores();
+	return error ? EXIT_FAILURE : EXIT_SUCCESS;
+}
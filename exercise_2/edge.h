@@ -0,0 +1,24 @@
+/**
+ * @file
+ * @brief edge module defines the representation of a directed edge that is shared by the graph modules and the shared buffer
+ *
+ * @autor Benjamin Deutsch (12215881)
+ * @date 16.11.2023
+ */
+#ifndef EDGE_H
+#define EDGE_H
+
+#include <stdint.h>
+
+/**
+ * @brief represents a directed edge between two vertices
+ * @details the edge originates from the vertex with the id source and ends in the vertex with the id destination.
+ *          The struct consists of two packed 32 bit integers, so that arrays of edges can be copied into the shared
+ *          memory without any formatting.
+ */
+typedef struct edge {
+	int32_t source;
+	int32_t destination;
+} edge_t;
+
+#endif /* EDGE_H */
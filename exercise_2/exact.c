@@ -0,0 +1,553 @@
+#include "exact.h"
+#include "sampler.h"
+#include "local_search.h"
+#include "rng.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEURISTIC_ROUNDS 32
+#define HEURISTIC_SEED 12215881
+#define QUIT_CHECK_INTERVAL 1024
+
+/**
+ * @brief computes the degrees without self loops and the mutual neighbours of the vertices of a component
+ * @param component the component whose graph is already set
+ * @param count_out working memory with one zero initialized entry per vertex, zero again afterwards
+ * @param count_in working memory with one zero initialized entry per vertex, zero again afterwards
+ * @return 0 on success, -1 if a memory allocation error occured
+ */
+static int init_degrees(exact_component_t *component, uint32_t *count_out, uint32_t *count_in) {
+	const graph_t *graph = component->graph;
+	size_t v, e, n = graph->vertex_count;
+	component->out_degree = calloc(n, sizeof(uint32_t));
+	component->in_degree = calloc(n, sizeof(uint32_t));
+	component->mutual_offsets = calloc(n + 1, sizeof(size_t));
+	component->mutual_vertices = malloc(graph->edge_count * sizeof(uint32_t));
+	component->mutual_weights = malloc(graph->edge_count * sizeof(uint32_t));
+	if(component->out_degree == NULL || component->in_degree == NULL || component->mutual_offsets == NULL ||
+			component->mutual_vertices == NULL || component->mutual_weights == NULL){
+		perror("exact: Memory allocation error occured.");
+		return -1;
+	}
+	size_t length = 0;
+	for(v = 0; v < n; v++){
+		for(e = graph->offsets[v]; e < graph->offsets[v+1]; e++){
+			uint32_t w = graph->targets[e];
+			if(w == v){
+				component->loops++;
+			}else{
+				component->out_degree[v]++;
+				count_out[w]++;
+			}
+		}
+		for(e = graph->in_offsets[v]; e < graph->in_offsets[v+1]; e++){
+			uint32_t u = graph->sources[e];
+			if(u != v){
+				component->in_degree[v]++;
+				count_in[u]++;
+			}
+		}
+		//every neighbour is emitted once, count_out is reset when it is emitted
+		for(e = graph->offsets[v]; e < graph->offsets[v+1]; e++){
+			uint32_t w = graph->targets[e];
+			if(count_out[w] > 0 && count_in[w] > 0){
+				component->mutual_vertices[length] = w;
+				component->mutual_weights[length] = count_out[w] < count_in[w] ? count_out[w] : count_in[w];
+				component->mutual_total += component->mutual_weights[length];
+				length++;
+			}
+			count_out[w] = 0;
+		}
+		for(e = graph->in_offsets[v]; e < graph->in_offsets[v+1]; e++){
+			count_in[graph->sources[e]] = 0;
+		}
+		component->mutual_offsets[v+1] = length;
+	}
+	//every pair was counted from both sides
+	component->mutual_total /= 2;
+	return 0;
+}
+
+/**
+ * @brief computes an upper bound for the component by local search with a fixed seed
+ * @param component the component whose graph is already set
+ * @return 0 on success, -1 if a memory allocation error occured
+ */
+static int init_heuristic(exact_component_t *component) {
+	const graph_t *graph = component->graph;
+	component->heuristic_order = malloc(graph->vertex_count * sizeof(uint32_t));
+	sampler_t *sampler = create_sampler(graph);
+	local_search_t *search = create_local_search(graph);
+	if(component->heuristic_order == NULL || sampler == NULL || search == NULL){
+		if(sampler != NULL){
+			free_sampler(sampler);
+		}
+		if(search != NULL){
+			free_local_search(search);
+		}
+		perror("exact: Memory allocation error occured.");
+		return -1;
+	}
+	rng_t rng;
+	rng_seed(&rng, HEURISTIC_SEED);
+	int round;
+	component->heuristic_size = SIZE_MAX;
+	for(round = 0; round < HEURISTIC_ROUNDS; round++){
+		shuffle_order(sampler, &rng);
+		greedy_order(search, sampler);
+		size_t size = improve_order(search, sampler);
+		if(size < component->heuristic_size){
+			component->heuristic_size = size;
+			memcpy(component->heuristic_order, sampler->order, graph->vertex_count * sizeof(uint32_t));
+		}
+	}
+	free_local_search(search);
+	free_sampler(sampler);
+	return 0;
+}
+
+/**
+ * @brief returns whether the given component is solved by dynamic programming
+ * @param component the component
+ * @return true if the component is small enough for dynamic programming, false otherwise
+ */
+static bool use_dynamic_programming(const exact_component_t *component) {
+	return component->graph->vertex_count <= EXACT_DP_MAX_VERTICES && component->graph->edge_count < UINT16_MAX;
+}
+
+exact_problem_t* create_exact_problem(const graph_t *graph) {
+	size_t v, c, count;
+	exact_problem_t *problem = calloc(1, sizeof(exact_problem_t));
+	uint32_t *count_out = calloc(graph->vertex_count + 1, sizeof(uint32_t));
+	uint32_t *count_in = calloc(graph->vertex_count + 1, sizeof(uint32_t));
+	if(problem == NULL || count_out == NULL || count_in == NULL){
+		free(problem);
+		free(count_out);
+		free(count_in);
+		perror("exact: Memory allocation error occured.");
+		return NULL;
+	}
+	graph_t **subgraphs = split_components(graph, &count);
+	if(subgraphs == NULL || (problem->components = calloc(count + 1, sizeof(exact_component_t))) == NULL){
+		if(subgraphs != NULL){
+			free_components(subgraphs, count);
+		}
+		free(problem);
+		free(count_out);
+		free(count_in);
+		return NULL;
+	}
+	//the components take over the subgraphs
+	problem->component_count = count;
+	for(c = 0; c < count; c++){
+		problem->components[c].graph = subgraphs[c];
+	}
+	free(subgraphs);
+	size_t item_count = 0;
+	for(c = 0; c < count; c++){
+		exact_component_t *current = &problem->components[c];
+		if(init_degrees(current, count_out, count_in) == -1 || init_heuristic(current) == -1){
+			break;
+		}
+		item_count += use_dynamic_programming(current) ? 1 : current->graph->vertex_count;
+		if(current->graph->vertex_count > problem->max_vertices){
+			problem->max_vertices = current->graph->vertex_count;
+		}
+	}
+	free(count_out);
+	free(count_in);
+	if(c < count || (problem->items = malloc(item_count * sizeof(exact_item_t) + 1)) == NULL){
+		free_exact_problem(problem);
+		return NULL;
+	}
+	for(c = 0; c < problem->component_count; c++){
+		const exact_component_t *current = &problem->components[c];
+		if(use_dynamic_programming(current)){
+			problem->items[problem->item_count].component = c;
+			problem->items[problem->item_count].first = EXACT_NO_VERTEX;
+			problem->item_count++;
+			continue;
+		}
+		//promising first vertices first
+		for(v = 0; v < current->graph->vertex_count; v++){
+			problem->items[problem->item_count].component = c;
+			problem->items[problem->item_count].first = current->heuristic_order[v];
+			problem->item_count++;
+		}
+	}
+	return problem;
+}
+
+exact_solver_t* create_exact_solver(const exact_problem_t *problem) {
+	size_t c, n = problem->max_vertices;
+	exact_solver_t *solver = calloc(1, sizeof(exact_solver_t));
+	if(solver == NULL){
+		perror("exact: Memory allocation error occured.");
+		return NULL;
+	}
+	solver->problem = problem;
+	solver->best_sizes = malloc(problem->component_count * sizeof(size_t) + 1);
+	solver->best_orders = calloc(problem->component_count + 1, sizeof(uint32_t*));
+	solver->order = malloc(n * sizeof(uint32_t) + 1);
+	solver->position = malloc(n * sizeof(uint32_t) + 1);
+	solver->placed = malloc(n * sizeof(bool) + 1);
+	solver->remaining_in = malloc(n * sizeof(uint32_t) + 1);
+	solver->remaining_out = malloc(n * sizeof(uint32_t) + 1);
+	solver->mutual_remaining = malloc(n * sizeof(size_t) + 1);
+	solver->memo = malloc(((size_t)1 << EXACT_MEMO_BITS) * sizeof(exact_memo_entry_t));
+	solver->memo_component = EXACT_NO_VERTEX;
+	if(solver->best_sizes == NULL || solver->best_orders == NULL || solver->order == NULL ||
+			solver->position == NULL || solver->placed == NULL || solver->remaining_in == NULL ||
+			solver->remaining_out == NULL || solver->mutual_remaining == NULL || solver->memo == NULL){
+		free_exact_solver(solver);
+		perror("exact: Memory allocation error occured.");
+		return NULL;
+	}
+	for(c = 0; c < problem->component_count; c++){
+		const exact_component_t *component = &problem->components[c];
+		size_t size = component->graph->vertex_count * sizeof(uint32_t);
+		solver->best_sizes[c] = component->heuristic_size;
+		solver->best_orders[c] = malloc(size);
+		if(solver->best_orders[c] == NULL){
+			free_exact_solver(solver);
+			perror("exact: Memory allocation error occured.");
+			return NULL;
+		}
+		memcpy(solver->best_orders[c], component->heuristic_order, size);
+	}
+	return solver;
+}
+
+/**
+ * @brief solves a component by dynamic programming over the subsets of its vertices
+ * @details cost[S] is the minimum number of backward edges of an order of the vertices in S that are put in front
+ *          of all other vertices. Appending v to such an order adds the edges from v into S as backward edges, they
+ *          are counted with one bit mask per multiplicity of the edges.
+ * @param solver the working memory
+ * @param c the index of the component
+ * @return 0 on success, -1 if a memory allocation error occured
+ */
+static int solve_dynamic_programming(exact_solver_t *solver, uint32_t c) {
+	const exact_component_t *component = &solver->problem->components[c];
+	const graph_t *graph = component->graph;
+	uint32_t v, n = graph->vertex_count;
+	size_t e, layers = 1;
+	//layer k contains the destinations of the edges of multiplicity larger than k
+	uint32_t *masks = calloc(graph->edge_count * n + 1, sizeof(uint32_t));
+	uint16_t *cost = malloc(((size_t)1 << n) * sizeof(uint16_t));
+	if(masks == NULL || cost == NULL){
+		free(masks);
+		free(cost);
+		perror("exact: Memory allocation error occured.");
+		return -1;
+	}
+	for(v = 0; v < n; v++){
+		for(e = graph->offsets[v]; e < graph->offsets[v+1]; e++){
+			uint32_t w = graph->targets[e], bit = (uint32_t)1 << w, k = 0;
+			if(w == v){
+				continue;
+			}
+			while(masks[k * n + v] & bit){
+				k++;
+			}
+			masks[k * n + v] |= bit;
+			if(k + 1 > layers){
+				layers = k + 1;
+			}
+		}
+	}
+	uint32_t set, full = ((uint32_t)1 << n) - 1;
+	cost[0] = 0;
+	for(set = 1; set <= full; set++){
+		uint32_t rest = set, best = UINT32_MAX;
+		while(rest != 0){
+			v = __builtin_ctz(rest);
+			rest &= rest - 1;
+			uint32_t others = set & ~((uint32_t)1 << v), value = cost[others];
+			size_t k;
+			for(k = 0; k < layers; k++){
+				value += __builtin_popcount(masks[k * n + v] & others);
+			}
+			if(value < best){
+				best = value;
+			}
+		}
+		cost[set] = best;
+	}
+	if(cost[full] + component->loops < solver->best_sizes[c]){
+		//reconstruct the order from the back
+		uint32_t position = n;
+		set = full;
+		while(set != 0){
+			uint32_t rest = set;
+			while(rest != 0){
+				v = __builtin_ctz(rest);
+				rest &= rest - 1;
+				uint32_t others = set & ~((uint32_t)1 << v), value = cost[others];
+				size_t k;
+				for(k = 0; k < layers; k++){
+					value += __builtin_popcount(masks[k * n + v] & others);
+				}
+				if(value == cost[set]){
+					solver->best_orders[c][--position] = v;
+					set = others;
+					break;
+				}
+			}
+		}
+		solver->best_sizes[c] = cost[full] + component->loops;
+	}
+	free(masks);
+	free(cost);
+	return 0;
+}
+
+/**
+ * @brief appends the given vertex to the current order of the branch and bound search
+ * @param solver the working memory
+ * @param component the component that is searched
+ * @param v the vertex
+ * @param depth the position of the vertex
+ */
+static void place(exact_solver_t *solver, const exact_component_t *component, uint32_t v, size_t depth) {
+	const graph_t *graph = component->graph;
+	size_t e;
+	solver->placed[v] = true;
+	solver->placed_set |= (uint64_t)1 << (v & 63);
+	solver->order[depth] = v;
+	for(e = graph->offsets[v]; e < graph->offsets[v+1]; e++){
+		if(graph->targets[e] != v){
+			solver->remaining_in[graph->targets[e]]--;
+		}
+	}
+	for(e = graph->in_offsets[v]; e < graph->in_offsets[v+1]; e++){
+		if(graph->sources[e] != v){
+			solver->remaining_out[graph->sources[e]]--;
+		}
+	}
+	for(e = component->mutual_offsets[v]; e < component->mutual_offsets[v+1]; e++){
+		solver->mutual_remaining[component->mutual_vertices[e]] -= component->mutual_weights[e];
+	}
+}
+
+/**
+ * @brief removes the given vertex from the end of the current order of the branch and bound search
+ * @param solver the working memory
+ * @param component the component that is searched
+ * @param v the vertex
+ */
+static void unplace(exact_solver_t *solver, const exact_component_t *component, uint32_t v) {
+	const graph_t *graph = component->graph;
+	size_t e;
+	solver->placed[v] = false;
+	solver->placed_set &= ~((uint64_t)1 << (v & 63));
+	for(e = graph->offsets[v]; e < graph->offsets[v+1]; e++){
+		if(graph->targets[e] != v){
+			solver->remaining_in[graph->targets[e]]++;
+		}
+	}
+	for(e = graph->in_offsets[v]; e < graph->in_offsets[v+1]; e++){
+		if(graph->sources[e] != v){
+			solver->remaining_out[graph->sources[e]]++;
+		}
+	}
+	for(e = component->mutual_offsets[v]; e < component->mutual_offsets[v+1]; e++){
+		solver->mutual_remaining[component->mutual_vertices[e]] += component->mutual_weights[e];
+	}
+}
+
+/**
+ * @brief checks whether the current set of placed vertices was already reached with at most the given cost
+ * @details if it was not, the cost is stored in the memo table. Subtrees are only skipped if they were searched with
+ *          a cost that is not larger, and the upper bound never increases, so no better solution is skipped.
+ * @param solver the working memory
+ * @param cost the number of backward edges of the current order
+ * @return true if the subtree of the current order can be skipped, false otherwise
+ */
+static bool visited(exact_solver_t *solver, size_t cost) {
+	uint64_t set = solver->placed_set;
+	uint64_t hash = set * 0x9e3779b97f4a7c15ULL;
+	exact_memo_entry_t *entry = &solver->memo[hash >> (64 - EXACT_MEMO_BITS)];
+	//the empty set is never looked up, so a zero set marks an empty entry
+	if(entry->set == set && entry->cost <= cost){
+		return true;
+	}
+	entry->set = set;
+	entry->cost = cost;
+	return false;
+}
+
+/**
+ * @brief searches all orders that start with the current order of the solver
+ * @details placing v costs its edges into the placed vertices. Every edge from a remaining vertex into a placed
+ *          vertex is a backward edge in every completion of the order, and every pair of remaining vertices with
+ *          edges in both directions costs at least the smaller multiplicity, which together give the lower bound.
+ *          If a remaining vertex has no edges from other remaining vertices, putting it next is never worse, so it
+ *          is the only branch. Vertices without edges to other remaining vertices are never worse at the end, so
+ *          they are not branched on and appended once only such vertices remain.
+ * @param solver the working memory
+ * @param c the index of the component
+ * @param depth the length of the current order
+ * @param cost the number of backward edges of the current order
+ * @param forced the number of edges from the remaining vertices into the placed vertices
+ * @param lower_bound the lower bound for the cost of the pairs of remaining vertices
+ */
+static void branch(exact_solver_t *solver, uint32_t c, size_t depth, size_t cost, size_t forced, size_t lower_bound) {
+	const exact_component_t *component = &solver->problem->components[c];
+	size_t i, n = component->graph->vertex_count;
+	if(solver->aborted){
+		return;
+	}
+	if(++solver->nodes % QUIT_CHECK_INTERVAL == 0 && *solver->quit){
+		solver->aborted = true;
+		return;
+	}
+	if(n <= EXACT_MEMO_MAX_VERTICES && visited(solver, cost)){
+		return;
+	}
+	uint32_t source = EXACT_NO_VERTEX;
+	bool only_sinks = true;
+	for(i = 0; i < n; i++){
+		uint32_t v = component->heuristic_order[i];
+		if(solver->placed[v]){
+			continue;
+		}
+		if(solver->remaining_out[v] > 0){
+			only_sinks = false;
+		}
+		if(source == EXACT_NO_VERTEX && solver->remaining_in[v] == 0){
+			source = v;
+		}
+	}
+	if(only_sinks){
+		//the remaining vertices have no edges between each other, only their forced edges are left
+		if(cost + forced + component->loops < solver->best_sizes[c]){
+			solver->best_sizes[c] = cost + forced + component->loops;
+			memcpy(solver->best_orders[c], solver->order, depth * sizeof(uint32_t));
+			for(i = 0; i < n; i++){
+				if(!solver->placed[component->heuristic_order[i]]){
+					solver->best_orders[c][depth++] = component->heuristic_order[i];
+				}
+			}
+		}
+		return;
+	}
+	for(i = 0; i < n; i++){
+		uint32_t v = source != EXACT_NO_VERTEX ? source : component->heuristic_order[i];
+		if(!solver->placed[v] && (source != EXACT_NO_VERTEX || solver->remaining_out[v] > 0)){
+			size_t increase = component->out_degree[v] - solver->remaining_out[v];
+			size_t next_forced = forced - increase + solver->remaining_in[v];
+			size_t next_bound = lower_bound - solver->mutual_remaining[v];
+			if(cost + increase + next_forced + next_bound + component->loops < solver->best_sizes[c]){
+				place(solver, component, v, depth);
+				branch(solver, c, depth + 1, cost + increase, next_forced, next_bound);
+				unplace(solver, component, v);
+			}
+		}
+		if(source != EXACT_NO_VERTEX){
+			break;
+		}
+	}
+}
+
+/**
+ * @brief searches all orders of a component that start with the given vertex
+ * @param solver the working memory
+ * @param c the index of the component
+ * @param first the first vertex
+ */
+static void solve_branch_and_bound(exact_solver_t *solver, uint32_t c, uint32_t first) {
+	const exact_component_t *component = &solver->problem->components[c];
+	size_t v, e, n = component->graph->vertex_count;
+	for(v = 0; v < n; v++){
+		solver->placed[v] = false;
+		solver->remaining_in[v] = component->in_degree[v];
+		solver->remaining_out[v] = component->out_degree[v];
+		solver->mutual_remaining[v] = 0;
+		for(e = component->mutual_offsets[v]; e < component->mutual_offsets[v+1]; e++){
+			solver->mutual_remaining[v] += component->mutual_weights[e];
+		}
+	}
+	if(solver->memo_component != c){
+		memset(solver->memo, 0, ((size_t)1 << EXACT_MEMO_BITS) * sizeof(exact_memo_entry_t));
+		solver->memo_component = c;
+	}
+	solver->placed_set = 0;
+	size_t forced = solver->remaining_in[first];
+	size_t lower_bound = component->mutual_total - solver->mutual_remaining[first];
+	if(forced + lower_bound + component->loops < solver->best_sizes[c]){
+		place(solver, component, first, 0);
+		branch(solver, c, 1, 0, forced, lower_bound);
+		unplace(solver, component, first);
+	}
+}
+
+int solve_exact_item(exact_solver_t *solver, size_t item, const volatile bool *quit) {
+	const exact_item_t *current = &solver->problem->items[item];
+	solver->quit = quit;
+	solver->aborted = false;
+	if(current->first == EXACT_NO_VERTEX){
+		return solve_dynamic_programming(solver, current->component);
+	}
+	solve_branch_and_bound(solver, current->component, current->first);
+	return solver->aborted ? 1 : 0;
+}
+
+size_t get_component_solution(exact_solver_t *solver, uint32_t component, edge_t *edges, size_t max_edges) {
+	const graph_t *graph = solver->problem->components[component].graph;
+	size_t v, e, count = 0;
+	for(v = 0; v < graph->vertex_count; v++){
+		solver->position[solver->best_orders[component][v]] = v;
+	}
+	for(v = 0; v < graph->vertex_count; v++){
+		for(e = graph->offsets[v]; e < graph->offsets[v+1]; e++){
+			if(solver->position[v] >= solver->position[graph->targets[e]]){
+				if(count < max_edges){
+					edges[count].source = graph->ids[v];
+					edges[count].destination = graph->ids[graph->targets[e]];
+				}
+				count++;
+			}
+		}
+	}
+	return count;
+}
+
+void free_exact_solver(exact_solver_t *solver) {
+	size_t c;
+	if(solver->best_orders != NULL){
+		for(c = 0; c < solver->problem->component_count; c++){
+			free(solver->best_orders[c]);
+		}
+	}
+	free(solver->best_sizes);
+	free(solver->best_orders);
+	free(solver->order);
+	free(solver->position);
+	free(solver->placed);
+	free(solver->remaining_in);
+	free(solver->remaining_out);
+	free(solver->mutual_remaining);
+	free(solver->memo);
+	free(solver);
+}
+
+void free_exact_problem(exact_problem_t *problem) {
+	size_t c;
+	for(c = 0; c < problem->component_count; c++){
+		exact_component_t *component = &problem->components[c];
+		if(component->graph != NULL){
+			free_graph(component->graph);
+		}
+		free(component->heuristic_order);
+		free(component->out_degree);
+		free(component->in_degree);
+		free(component->mutual_offsets);
+		free(component->mutual_vertices);
+		free(component->mutual_weights);
+	}
+	free(problem->components);
+	free(problem->items);
+	free(problem);
+}
@@ -0,0 +1,149 @@
+/**
+ * @file
+ * @brief exact module computes minimum feedback arc sets by dynamic programming and branch and bound
+ *
+ * @autor Benjamin Deutsch (12215881)
+ * @date 16.11.2023
+ */
+#ifndef EXACT_H
+#define EXACT_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "edge.h"
+#include "graph.h"
+
+#define EXACT_DP_MAX_VERTICES 20 //2^20 16 bit costs = 2MB
+#define EXACT_MEMO_MAX_VERTICES 64
+#define EXACT_MEMO_BITS 20 //2^20 entries of 16 bytes = 16MB per thread
+#define EXACT_NO_VERTEX UINT32_MAX
+
+/**
+ * @brief an entry of the table of placed vertex sets that the branch and bound search has already visited
+ */
+typedef struct exact_memo_entry {
+	uint64_t set;
+	uint64_t cost;
+} exact_memo_entry_t;
+
+/**
+ * @brief a strongly connected component with at least one edge, which is solved independently of the others
+ * @details the heuristic order is the best order found by local search and its size the number of backward edges
+ *          of that order including self loops. The mutual arrays store for every vertex the neighbours that it has
+ *          edges to in both directions together with the smaller multiplicity of the two directions, which is a
+ *          lower bound for the cost of that pair of vertices.
+ */
+typedef struct exact_component {
+	graph_t *graph;
+	uint32_t *heuristic_order;
+	size_t heuristic_size;
+	size_t loops;
+	uint32_t *out_degree;
+	uint32_t *in_degree;
+	size_t *mutual_offsets;
+	uint32_t *mutual_vertices;
+	uint32_t *mutual_weights;
+	size_t mutual_total;
+} exact_component_t;
+
+/**
+ * @brief a unit of work, either a whole component that is solved by dynamic programming or the subtree of the
+ *        branch and bound search of a component in which the given vertex comes first
+ */
+typedef struct exact_item {
+	uint32_t component;
+	uint32_t first;
+} exact_item_t;
+
+/**
+ * @brief the decomposition of a graph into independent components and work items
+ * @details the decomposition is deterministic, so every generator that reads the same graph computes the same
+ *          components and items and the items can be distributed by their index only. The size of a minimum
+ *          feedback arc set of the graph is the sum of the minimum sizes of the components.
+ */
+typedef struct exact_problem {
+	exact_component_t *components;
+	size_t component_count;
+	exact_item_t *items;
+	size_t item_count;
+	size_t max_vertices;
+} exact_problem_t;
+
+/**
+ * @brief the working memory of one thread that solves items of an exact problem
+ * @details best_sizes and best_orders store the best solution of every component that this solver knows of, they
+ *          are used as upper bounds of the search. The remaining arrays are indexed by the vertices of the
+ *          component that is currently searched. For components with at most EXACT_MEMO_MAX_VERTICES vertices the
+ *          memo table stores the smallest cost with which a set of placed vertices was reached, a subtree that is
+ *          reached again with a cost that is not smaller is skipped.
+ */
+typedef struct exact_solver {
+	const exact_problem_t *problem;
+	size_t *best_sizes;
+	uint32_t **best_orders;
+	uint32_t *order;
+	uint32_t *position;
+	bool *placed;
+	uint32_t *remaining_in;
+	uint32_t *remaining_out;
+	size_t *mutual_remaining;
+	exact_memo_entry_t *memo;
+	uint32_t memo_component;
+	uint64_t placed_set;
+	const volatile bool *quit;
+	size_t nodes;
+	bool aborted;
+} exact_solver_t;
+
+/**
+ * @brief decomposes the given graph into its strongly connected components and creates the work items
+ * @details components without edges are dropped. Every component gets an upper bound from local search. Components
+ *          with at most EXACT_DP_MAX_VERTICES vertices are one item, larger components get one item per vertex.
+ * @param graph the graph
+ * @return NULL if a memory allocation error occured, the problem otherwise
+ */
+exact_problem_t* create_exact_problem(const graph_t *graph);
+
+/**
+ * @brief creates the working memory of a thread for the given problem
+ * @param problem the problem, has to outlive the solver
+ * @return NULL if a memory allocation error occured, the solver otherwise
+ */
+exact_solver_t* create_exact_solver(const exact_problem_t *problem);
+
+/**
+ * @brief computes the best solution of the component of the given item within the subtree of the item
+ * @details small components are solved by dynamic programming over the subsets of their vertices, larger ones by
+ *          branch and bound. The best solution of the component that the solver knows of is updated if the item
+ *          contains a better one.
+ * @param solver the working memory
+ * @param item the index of the item
+ * @param quit the search is aborted as soon as the value of this flag is true
+ * @return 0 if the item was solved, 1 if the search was aborted, -1 if a memory allocation error occured
+ */
+int solve_exact_item(exact_solver_t *solver, size_t item, const volatile bool *quit);
+
+/**
+ * @brief writes the edges of the best solution of the given component that the solver knows of into the given array
+ * @param solver the working memory
+ * @param component the component
+ * @param edges the array that the edges should be written into
+ * @param max_edges the maximum number of edges that should be written into the array
+ * @return the size of the solution, which may be larger than max_edges
+ */
+size_t get_component_solution(exact_solver_t *solver, uint32_t component, edge_t *edges, size_t max_edges);
+
+/**
+ * @brief frees all of the dynamically allocated memory of the given solver, including the solver itself
+ * @param solver the solver to be freed
+ */
+void free_exact_solver(exact_solver_t *solver);
+
+/**
+ * @brief frees all of the dynamically allocated memory of the given problem, including the problem itself
+ * @param problem the problem to be freed
+ */
+void free_exact_problem(exact_problem_t *problem);
+
+#endif /* EXACT_H */
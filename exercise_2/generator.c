@@ -5,126 +5,544 @@
  * @autor Benjamin Deutsch (12215881)
  * @date 16.11.2023
  */
-#include "adjacency_list.h"
+#include "graph.h"
+#include "graph_file.h"
+#include "sampler.h"
+#include "local_search.h"
+#include "exact.h"
+#include "rng.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
-#include <assert.h>
+#include <pthread.h>
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include "shared_buffer.h"
 
+#define BATCH_SIZE 8
+#define BATCH_FLUSH_INTERVAL_NS 10000000L //publish pending solutions at least every 10ms
+#define SAMPLE_REPORT_INTERVAL 256 //the number of samples a thread evaluates before it adds them to the shared counter
+
+/**
+ * @brief the state of a sampling thread
+ * @details the components of the graph, the exact problem and the shared data are shared by all threads, everything
+ *          else is owned by the thread. samplers and searches contain one entry per component. Every solution in the
+ *          batch can hold the largest solution that fits into the shared buffer. seed is the feedback arc set of a
+ *          checkpoint or NULL, seeded is true as long as the orders of the samplers are derived from it and have not
+ *          been sampled yet.
+ */
+typedef struct worker {
+	pthread_t thread;
+	graph_t **components;
+	size_t component_count;
+	sampler_t **samplers;
+	local_search_t **searches;
+	shared_data_t *shared_data;
+	const exact_problem_t *problem;
+	rng_t rng;
+	bool improve;
+	const edge_list_t *seed;
+	bool seeded;
+	solution_t *batch[BATCH_SIZE];
+	size_t pending;
+	int result;
+} worker_t;
+
+/**
+ * @brief prints the usage message for the generator
+ */
+static void print_usage_message(void) {
+	fprintf(stderr, "USAGE: generator [-i instance] [-t threads] [-e | [-l] [-r CHECKPOINT]] {-f FILE | [--] EDGE...}\n");
+}
+
+/**
+ * @brief returns the nanoseconds elapsed between the two given points in time
+ * @param start the earlier point in time
+ * @param end the later point in time
+ * @return the elapsed nanoseconds
+ */
+static long elapsed_ns(const struct timespec *start, const struct timespec *end) {
+	return (end->tv_sec - start->tv_sec) * 1000000000L + (end->tv_nsec - start->tv_nsec);
+}
+
+/**
+ * @brief frees the solutions of the batch of the given worker
+ * @param worker the worker
+ */
+static void free_batch(worker_t *worker) {
+	size_t i;
+	for(i = 0; i < BATCH_SIZE; i++){
+		free(worker->batch[i]);
+		worker->batch[i] = NULL;
+	}
+}
+
+/**
+ * @brief allocates the solutions of the batch of the given worker
+ * @param worker the worker
+ * @return 0 on success, -1 if a memory allocation error occured
+ */
+static int create_batch(worker_t *worker) {
+	size_t i;
+	for(i = 0; i < BATCH_SIZE; i++){
+		worker->batch[i] = create_solution(get_max_solution_size(worker->shared_data));
+		if(worker->batch[i] == NULL){
+			free_batch(worker);
+			return -1;
+		}
+		worker->batch[i]->generator = getpid();
+	}
+	return 0;
+}
+
+/**
+ * @brief frees the samplers and local searches of the given worker
+ * @param worker the worker
+ */
+static void free_samplers(worker_t *worker) {
+	size_t c;
+	for(c = 0; c < worker->component_count; c++){
+		if(worker->samplers[c] != NULL){
+			free_sampler(worker->samplers[c]);
+		}
+		if(worker->searches[c] != NULL){
+			free_local_search(worker->searches[c]);
+		}
+	}
+	free(worker->samplers);
+	free(worker->searches);
+}
+
+/**
+ * @brief creates a sampler and, if the improvement stage is enabled, a local search for every component
+ * @details if the worker has a seed, the initial orders of the samplers are topological orders of the components
+ *          without the edges of the seed.
+ * @param worker the worker
+ * @return 0 on success, -1 if a memory allocation error occured
+ */
+static int create_samplers(worker_t *worker) {
+	size_t c;
+	worker->samplers = calloc(worker->component_count + 1, sizeof(sampler_t*));
+	worker->searches = calloc(worker->component_count + 1, sizeof(local_search_t*));
+	if(worker->samplers == NULL || worker->searches == NULL){
+		free(worker->samplers);
+		free(worker->searches);
+		perror("generator: Memory allocation error");
+		return -1;
+	}
+	for(c = 0; c < worker->component_count; c++){
+		worker->samplers[c] = create_sampler(worker->components[c]);
+		if(worker->samplers[c] == NULL || (worker->seed != NULL &&
+				seed_order(worker->samplers[c], worker->seed->edges, worker->seed->edge_count) == -1)){
+			free_samplers(worker);
+			return -1;
+		}
+		if(worker->improve){
+			worker->searches[c] = create_local_search(worker->components[c]);
+			if(worker->searches[c] == NULL){
+				free_samplers(worker);
+				return -1;
+			}
+		}
+	}
+	worker->seeded = worker->seed != NULL;
+	return 0;
+}
+
+/**
+ * @brief samples a feedback arc set of every component and combines them into a feedback arc set of the graph
+ * @details stops as soon as the combined feedback arc set has more than max_edges edges. The first sample after
+ *          the samplers were seeded starts from the seeded orders instead of random ones, and skips the greedy
+ *          order, so that local search continues from the checkpoint.
+ * @param worker the worker
+ * @param edges the buffer that the edges should be written into
+ * @param max_edges the maximum number of edges that should be written into the buffer
+ * @return the size of the feedback arc set if it is at most max_edges, max_edges + 1 otherwise
+ */
+static size_t sample(worker_t *worker, edge_t *edges, size_t max_edges) {
+	size_t c, count = 0;
+	bool seeded = worker->seeded;
+	worker->seeded = false;
+	for(c = 0; c < worker->component_count && count <= max_edges; c++){
+		sampler_t *sampler = worker->samplers[c];
+		if(!seeded){
+			shuffle_order(sampler, &worker->rng);
+		}
+		if(worker->searches[c] != NULL){
+			if(!seeded){
+				greedy_order(worker->searches[c], sampler);
+			}
+			if(count + improve_order(worker->searches[c], sampler) > max_edges){
+				return max_edges + 1;
+			}
+		}
+		count += collect_feedback_arcs(sampler, edges + count, max_edges - count);
+	}
+	return count;
+}
+
+/**
+ * @brief samples random feedback arc sets and publishes them in batches until the supervisor tells it to quit
+ * @details every strongly connected component is sampled independently. If the improvement stage is enabled, every
+ *          random order is replaced by the greedy order of Eades, Lin and Smyth (with the random order breaking ties)
+ *          and then improved by local search. Only solutions that are smaller than the best size in the shared memory
+ *          and than the pending solutions are published, and sampling stops as soon as a solution can not beat that
+ *          bound. If the supervisor asks for every solution, the bound is the largest solution that fits into the
+ *          buffer instead. Pending solutions are written to the shared memory as soon as the batch is full, the
+ *          oldest pending solution is older than BATCH_FLUSH_INTERVAL_NS or a solution without edges was found.
+ *          Every sample is counted, whether it is published or not, and the count is added to the shared sample
+ *          counter every SAMPLE_REPORT_INTERVAL samples and whenever solutions are published.
+ * @param arg the worker_t of the thread
+ * @return NULL
+ */
+static void* run_worker(void *arg) {
+	worker_t *worker = arg;
+	struct timespec first_pending, now;
+	bool quit = false;
+	uint64_t samples = 0;
+	worker->pending = 0;
+	worker->result = 0;
+	if(create_samplers(worker) == -1){
+		worker->result = -1;
+		return NULL;
+	}
+	if(create_batch(worker) == -1){
+		free_samplers(worker);
+		worker->result = -1;
+		return NULL;
+	}
+	int unbounded = get_max_solution_size(worker->shared_data) + 1;
+	while(!quit && !worker->shared_data->quit) {
+		int bound = unbounded;
+		if(!get_publish_all(worker->shared_data)){
+			bound = get_best_size(worker->shared_data);
+			if(worker->pending > 0 && worker->batch[worker->pending-1]->size < bound){
+				bound = worker->batch[worker->pending-1]->size;
+			}
+		}
+		solution_t *solution = worker->batch[worker->pending];
+		bool flush = false;
+		if(bound > 0){
+			size_t max_edges = bound - 1;
+			size_t edgeCount = sample(worker, solution->edges, max_edges);
+			samples++;
+			if(edgeCount <= max_edges) {
+				solution->size = edgeCount;
+				solution->kind = SOLUTION_SAMPLE;
+				if(worker->pending == 0){
+					clock_gettime(CLOCK_MONOTONIC, &first_pending);
+				}
+				worker->pending++;
+				flush = worker->pending == BATCH_SIZE || edgeCount == 0;
+			}
+		}
+		if(worker->pending > 0 && !flush){
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			flush = elapsed_ns(&first_pending, &now) >= BATCH_FLUSH_INTERVAL_NS;
+		}
+		if(samples == SAMPLE_REPORT_INTERVAL || (flush && samples > 0)){
+			add_samples(worker->shared_data, samples);
+			samples = 0;
+		}
+		if(flush){
+			quit = write_solutions(worker->shared_data, (const solution_t *const *)worker->batch, worker->pending);
+			worker->pending = 0;
+		}
+	}
+	add_samples(worker->shared_data, samples);
+	free_batch(worker);
+	free_samplers(worker);
+	return NULL;
+}
+
+/**
+ * @brief takes work items of the exact solver and publishes their results until no items are left
+ * @details the result of an item is the best solution of its component that this thread knows of after the item
+ *          was solved. The supervisor combines the results of all items. An item is only recorded as finished once
+ *          its result was written, so the items of a generator that crashes are solved by another one.
+ * @param arg the worker_t of the thread
+ * @return NULL
+ */
+static void* run_exact_worker(void *arg) {
+	worker_t *worker = arg;
+	const exact_problem_t *problem = worker->problem;
+	bool quit = false;
+	worker->result = 0;
+	exact_solver_t *solver = create_exact_solver(problem);
+	if(solver == NULL){
+		worker->result = -1;
+		return NULL;
+	}
+	size_t max_edges = get_max_solution_size(worker->shared_data);
+	solution_t *solution = create_solution(max_edges);
+	if(solution == NULL){
+		free_exact_solver(solver);
+		worker->result = -1;
+		return NULL;
+	}
+	solution->generator = getpid();
+	while(!quit && !worker->shared_data->quit) {
+		size_t slot;
+		unsigned int item = take_work_item(worker->shared_data, problem->item_count, &slot);
+		if(item >= problem->item_count){
+			break;
+		}
+		int result = solve_exact_item(solver, item, &worker->shared_data->quit);
+		if(result != 0){
+			worker->result = result;
+			break;
+		}
+		solution->kind = SOLUTION_EXACT;
+		solution->component = problem->items[item].component;
+		solution->component_count = problem->component_count;
+		solution->item_count = problem->item_count;
+		solution->item = item;
+		solution->size = get_component_solution(solver, solution->component, solution->edges, max_edges);
+		quit = write_solution(worker->shared_data, solution);
+		if(!quit){
+			finish_work_item(worker->shared_data, slot);
+		}
+	}
+	free(solution);
+	free_exact_solver(solver);
+	return NULL;
+}
+
 /**
- * @brief shuffles the vertices of the adjacency list randomly
- * @details implements the Fisher–Yates shuffle to reorder the items of the vertices array 
- *          of the given adjacency list randomly
- * @param list the list whose vertices should be shuffled randomly
+ * @brief parses the edges given as positional arguments
+ * @param count the number of arguments
+ * @param arguments the arguments with the syntax [int]-[int]
+ * @param list the edge list that should be filled
+ * @return 0 on success, -1 if an argument is invalid or a memory allocation error occured
  */
-static void shuffle(adjacency_list_t *list) {
-	//seed the random number generator with the current time
+static int parse_edge_arguments(int count, char *arguments[], edge_list_t *list) {
+	memset(list, 0, sizeof(edge_list_t));
+	list->parsed = malloc(count * sizeof(edge_t));
+	if(list->parsed == NULL){
+		perror("generator: Memory allocation error");
+		return -1;
+	}
 	int i;
-	for(i = list->length-1; i > 0; i--) {
-		//generate a random number x <= i
-		int x = rand() % (i+1);
-		vertex_node_t swap = list->vertices[i];
-		list->vertices[i] = list->vertices[x];
-		list->vertices[x] = swap;
+	for(i = 0; i < count; i++){
+		int v1, v2;
+		if(sscanf(arguments[i], "%d-%d", &v1, &v2) != 2){
+			free_edge_list(list);
+			fprintf(stderr, "generator: Invalid input\n");
+			return -1;
+		}
+		list->parsed[i].source = v1;
+		list->parsed[i].destination = v2;
 	}
+	list->edges = list->parsed;
+	list->edge_count = count;
+	return 0;
 }
 
 /**
  * @brief gets a graph as input and finds random feedback arc set solutions
- * @details gets a list of edges as positional arguments and creates an adjacency list from the input.
- *          The adjacency list entries are randomly shuffled to generate random feedback arc set solutions,
+ * @details gets a list of edges as positional arguments or from a graph file and creates a compressed sparse row
+ *          graph from the input.
+ *          The order of the vertices is randomly shuffled to generate random feedback arc set solutions,
  *          which are written to the shared memory repeatedly until the supervisor tells the generator to 
- *          terminate.
+ *          terminate. The graph is split into its strongly connected components first, which are sampled
+ *          independently, so acyclic parts of the graph cost nothing and acyclic graphs are reported instantly. The
+ *          components are shared read-only by all sampling threads, every thread uses its own random number generator.
  * @param argc the number of arguments
- * @param argv should only contain positional arguments seperated by spaces with the following syntax: [int]-[int]
+ * @param argv can contain the following arguments:
+ *             -i [str]: the instance of the supervisor the solutions are written to, the default instance otherwise
+ *             -t [int]: the number of sampling threads, 1 by default
+ *             -l:       improve every sample with a greedy initial order and local search before publishing it
+ *             -r [str]: start from the feedback arc set in the given checkpoint of the supervisor. The first sample
+ *                       of every thread uses a topological order of the graph without these edges, which the
+ *                       improvement stage then tries to improve, so this is most useful together with -l
+ *             -f [str]: read the edges from the given binary graph file or text edge list instead of the
+ *                       positional arguments, - reads them from stdin. Binary graph files are mapped read-only,
+ *                       so they are neither copied nor parsed. Every generator still builds its own graph from
+ *                       the edges and unmaps the file afterwards, so only the loading is shared, not the graph.
+ *             -e:       compute a minimum feedback arc set instead of sampling. The graph is split into strongly
+ *                       connected components, which are split into work items. The items are distributed over all
+ *                       generators and threads, so every generator has to be given the same graph. -l and -r only
+ *                       apply to sampling, so they cannot be combined with -e
+ *             the remaining positional arguments are the edges of the graph with the following syntax: [int]-[int].
+ *             Use -- before the edges if the first edge starts with a negative vertex id.
  * @return EXIT_SUCCESS if the programm executed successfully, EXIT_FAILURE otherwise
  */
 int main(int argc, char *argv[]) {
-	if(argc <= 1){
+	int c, count, thread_count = 1;
+	bool improve = false, exact = false;
+	const char *path = NULL, *checkpoint = NULL;
+	while((c = getopt(argc, argv, "+i:t:ler:f:")) != -1){
+		switch(c) {
+			case 'i':
+				if(set_shared_instance(optarg) == -1){
+					print_usage_message();
+					return EXIT_FAILURE;
+				}
+				break;
+			case 't':
+				count = sscanf(optarg, "%d", &thread_count);
+				if(count != 1 || thread_count < 1){
+					print_usage_message();
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'l':
+				improve = true;
+				break;
+			case 'e':
+				exact = true;
+				break;
+			case 'r':
+				checkpoint = optarg;
+				break;
+			case 'f':
+				path = optarg;
+				break;
+			default:
+				print_usage_message();
+				return EXIT_FAILURE;
+		}
+	}
+	if((path != NULL && argc - optind > 0) || (exact && (improve || checkpoint != NULL))){
+		print_usage_message();
+		return EXIT_FAILURE;
+	}
+	if(path == NULL && argc - optind < 1){
 		fprintf(stderr, "generator: No input provided\n");
 		return EXIT_FAILURE;
 	}
 	
+	//read graph from input
+	edge_list_t list;
+	if(path != NULL){
+		if(load_graph_file(path, &list) == -1){
+			return EXIT_FAILURE;
+		}
+		if(list.edge_count == 0){
+			free_edge_list(&list);
+			fprintf(stderr, "generator: No input provided\n");
+			return EXIT_FAILURE;
+		}
+	}else if(parse_edge_arguments(argc - optind, argv + optind, &list) == -1){
+		return EXIT_FAILURE;
+	}
+	//the graph is built straight from the mapped edges, but it is a private copy, so the mapping is released
+	graph_t *graph = create_graph(list.edges, list.edge_count);
+	free_edge_list(&list);
+	if(graph == NULL){
+		return EXIT_FAILURE;
+	}
+	
 	//link shared memory
-	int shmfd = init_shared_memory();
+	size_t shared_size;
+	int shmfd = init_shared_memory(&shared_size);
 	if(shmfd == -1){
+		free_graph(graph);
 		return EXIT_FAILURE;
 	}
-	shared_data_t *shared_data = mmap(NULL, sizeof(shared_data_t), PROT_READ | PROT_WRITE, MAP_SHARED, shmfd, 0);
+	shared_data_t *shared_data = mmap(NULL, shared_size, PROT_READ | PROT_WRITE, MAP_SHARED, shmfd, 0);
 	if(shared_data == MAP_FAILED){
 		close(shmfd);
+		free_graph(graph);
 		perror("generator: Shared memory mapping failed");
 		return EXIT_FAILURE;
 	}
 	if (close(shmfd) == -1){
+		free_graph(graph);
 		perror("generator: Error closing shared memory file descriptor");
 		return EXIT_FAILURE;
 	}
 	
-	//read list from input
-	int i;
-	adjacency_list_t *list = create_list();
-	for(i = 1; i < argc; i++){
-		int v1, v2;
-		int result = sscanf(argv[i],"%d-%d", &v1, &v2);
-		if(result != 2){
-			free_list_memory(list);
-			fprintf(stderr, "generator: Invalid input\n");
+	//only edges inside strongly connected components can lie on a cycle
+	exact_problem_t *problem = NULL;
+	graph_t **components = NULL;
+	size_t component_count;
+	if(exact){
+		problem = create_exact_problem(graph);
+		component_count = problem != NULL ? problem->component_count : 0;
+	}else{
+		components = split_components(graph, &component_count);
+	}
+	free_graph(graph);
+	if(problem == NULL && components == NULL){
+		return EXIT_FAILURE;
+	}
+	if(component_count == 0){
+		//the graph is acyclic, there is nothing to sample
+		solution_t solution;
+		solution.size = 0;
+		solution.kind = SOLUTION_SAMPLE;
+		solution.generator = getpid();
+		write_solution(shared_data, &solution);
+		thread_count = 0;
+	}
+	
+	//the checkpoint is only read by the threads while they create their samplers
+	edge_list_t seed;
+	bool seed_loaded = false;
+	if(checkpoint != NULL && !exact && component_count > 0){
+		if(load_graph_file(checkpoint, &seed) == -1){
+			free_components(components, component_count);
 			return EXIT_FAILURE;
-		}else{
-			if(!contains(list,v1)){
-				add_vertex(list,v1);
-			}
-			if(!contains(list,v2)){
-				add_vertex(list,v2);
-			}
-			add_edge(list,v1,v2);
 		}
+		seed_loaded = true;
 	}
+	
 	//generate feedback arcs
-	srand(time(NULL));
-	bool quit = false;
-	while(!quit) {
-		shuffle(list);
-		adjacency_list_t *feedback_arc = create_list();
-		//add vertices to feedback_arc list
-		for(i = 0; i < list->length; i++) {
-			add_vertex(feedback_arc,list->vertices[i].id);
-		}
-		//add edges
-		int edgeCount = 0;
-		for(i = 0; i < list->length; i++){
-			vertex_node_t *next = list->vertices[i].next;
-			while(next != NULL){
-				int index = index_of(list, next->id);
-				assert(index >= 0);
-				if(i < index) {
-					add_edge(feedback_arc, list->vertices[i].id, list->vertices[index].id);
-					edgeCount++;
-				}
-				next = next->next;
-			}
+	worker_t *workers = malloc(thread_count * sizeof(worker_t) + 1);
+	if(workers == NULL){
+		if(seed_loaded){
+			free_edge_list(&seed);
+		}
+		if(problem != NULL){
+			free_exact_problem(problem);
+		}else{
+			free_components(components, component_count);
 		}
-		
-		if(edgeCount <= 8) {
-			char *str = get_edges_string(feedback_arc);
-			quit = write_solution(shared_data, str);
-			free(str);
+		perror("generator: Memory allocation error");
+		return EXIT_FAILURE;
+	}
+	int started;
+	for(started = 0; started < thread_count; started++){
+		worker_t *worker = &workers[started];
+		worker->components = components;
+		worker->component_count = component_count;
+		worker->shared_data = shared_data;
+		worker->improve = improve;
+		worker->seed = seed_loaded ? &seed : NULL;
+		worker->problem = problem;
+		rng_seed(&worker->rng, rng_entropy_seed());
+		if(pthread_create(&worker->thread, NULL, exact ? run_exact_worker : run_worker, worker) != 0){
+			fprintf(stderr, "generator: Error creating thread\n");
+			break;
+		}
+	}
+	bool error = started < thread_count;
+	int i;
+	for(i = 0; i < started; i++){
+		pthread_join(workers[i].thread, NULL);
+		if(workers[i].result == -1){
+			error = true;
 		}
-		free_list_memory(feedback_arc);
 	}
 	
-	free_list_memory(list);
-	if (munmap(shared_data, sizeof(shared_data_t)) == -1){
-		perror("supervisor: Shared memory unmapping failed");
+	free(workers);
+	if(seed_loaded){
+		free_edge_list(&seed);
+	}
+	if(problem != NULL){
+		free_exact_problem(problem);
+	}else{
+		free_components(components, component_count);
+	}
+	if (munmap(shared_data, shared_size) == -1){
+		perror("generator: Shared memory unmapping failed");
 		return EXIT_FAILURE;
 	}
 	if(close_semaphores() == -1){
 		return EXIT_FAILURE;
 	}
-	return EXIT_SUCCESS;
+	return error ? EXIT_FAILURE : EXIT_SUCCESS;
 }
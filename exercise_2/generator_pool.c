@@ -0,0 +1,179 @@
+#define _GNU_SOURCE
+#include "generator_pool.h"
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/**
+ * @brief returns the nanoseconds elapsed between the two given points in time
+ * @param start the earlier point in time
+ * @param end the later point in time
+ * @return the elapsed nanoseconds
+ */
+static long elapsed_ns(const struct timespec *start, const struct timespec *end) {
+	return (end->tv_sec - start->tv_sec) * 1000000000L + (end->tv_nsec - start->tv_nsec);
+}
+
+generator_pool_t* create_generator_pool(size_t count, const char *path, char *const args[], size_t arg_count) {
+	generator_pool_t *pool = malloc(sizeof(generator_pool_t));
+	if(pool == NULL){
+		perror("generator_pool: Memory allocation error occured.");
+		return NULL;
+	}
+	pool->count = count;
+	pool->running = 0;
+	pool->failed = 0;
+	pool->restarts = 0;
+	pool->cpu_count = 0;
+	pool->generators = calloc(count, sizeof(pool_generator_t));
+	pool->argv = malloc((arg_count + 2) * sizeof(char*));
+	pool->cpus = malloc(CPU_SETSIZE * sizeof(int));
+	if(pool->generators == NULL || pool->argv == NULL || pool->cpus == NULL){
+		free_generator_pool(pool);
+		perror("generator_pool: Memory allocation error occured.");
+		return NULL;
+	}
+	pool->argv[0] = (char*)path;
+	memcpy(pool->argv + 1, args, arg_count * sizeof(char*));
+	pool->argv[arg_count + 1] = NULL;
+
+	cpu_set_t set;
+	int cpu;
+	if(sched_getaffinity(0, sizeof(set), &set) == 0){
+		for(cpu = 0; cpu < CPU_SETSIZE; cpu++){
+			if(CPU_ISSET(cpu, &set)){
+				pool->cpus[pool->cpu_count++] = cpu;
+			}
+		}
+	}
+	return pool;
+}
+
+/**
+ * @brief forks and executes the given generator of the pool
+ * @param pool the pool
+ * @param generator the generator, its cpu has to be set
+ * @return 0 if the process was created, -1 otherwise
+ */
+static int start_generator(generator_pool_t *pool, pool_generator_t *generator) {
+	pid_t pid = fork();
+	if(pid == -1){
+		perror("generator_pool: Error creating generator process");
+		return -1;
+	}
+	if(pid == 0){
+		if(generator->cpu != -1){
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			CPU_SET(generator->cpu, &set);
+			sched_setaffinity(0, sizeof(set), &set);
+		}
+		execvp(pool->argv[0], pool->argv);
+		perror("generator_pool: Error executing generator");
+		_exit(127);
+	}
+	generator->pid = pid;
+	clock_gettime(CLOCK_MONOTONIC, &generator->started);
+	pool->running++;
+	return 0;
+}
+
+int start_generators(generator_pool_t *pool) {
+	size_t i;
+	for(i = 0; i < pool->count; i++){
+		pool_generator_t *generator = &pool->generators[i];
+		generator->cpu = pool->cpu_count > 0 ? pool->cpus[i % pool->cpu_count] : -1;
+		if(start_generator(pool, generator) == -1){
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int restart_crashed_generators(generator_pool_t *pool, shared_data_t *data) {
+	int status;
+	pid_t pid;
+	while((pid = waitpid(-1, &status, WNOHANG)) > 0){
+		size_t i;
+		for(i = 0; i < pool->count && pool->generators[i].pid != pid; i++);
+		if(i == pool->count){
+			continue;
+		}
+		pool_generator_t *generator = &pool->generators[i];
+		generator->pid = 0;
+		pool->running--;
+		if(recover_writer(data, pid)){
+			fprintf(stderr, "generator_pool: Released the buffer held by generator %d\n", (int)pid);
+		}
+		unsigned int recovered = recover_work_items(data, pid);
+		if(recovered > 0){
+			fprintf(stderr, "generator_pool: Handing out %u unfinished work items of generator %d again\n",
+					recovered, (int)pid);
+		}
+		if(WIFEXITED(status)){
+			if(WEXITSTATUS(status) != EXIT_SUCCESS){
+				fprintf(stderr, "generator_pool: Generator %d failed with exit code %d\n", (int)pid,
+						WEXITSTATUS(status));
+				pool->failed++;
+			}
+			continue;
+		}
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		generator->fast_crashes = elapsed_ns(&generator->started, &now) < POOL_FAST_CRASH_NS ?
+				generator->fast_crashes + 1 : 0;
+		if(generator->fast_crashes >= POOL_MAX_FAST_CRASHES){
+			fprintf(stderr, "generator_pool: Generator %d crashed (signal %d) %d times in a row, giving up\n",
+					(int)pid, WTERMSIG(status), generator->fast_crashes);
+			pool->failed++;
+			continue;
+		}
+		fprintf(stderr, "generator_pool: Generator %d crashed (signal %d), restarting it\n", (int)pid,
+				WTERMSIG(status));
+		if(start_generator(pool, generator) == -1){
+			pool->failed++;
+			return -1;
+		}
+		pool->restarts++;
+	}
+	return 0;
+}
+
+void stop_generators(generator_pool_t *pool) {
+	struct timespec start, now;
+	size_t i;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while(pool->running > 0){
+		for(i = 0; i < pool->count; i++){
+			pool_generator_t *generator = &pool->generators[i];
+			if(generator->pid != 0 && waitpid(generator->pid, NULL, WNOHANG) != 0){
+				generator->pid = 0;
+				pool->running--;
+			}
+		}
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if(pool->running > 0 && elapsed_ns(&start, &now) >= POOL_STOP_TIMEOUT_MS * 1000000L){
+			for(i = 0; i < pool->count; i++){
+				if(pool->generators[i].pid != 0){
+					fprintf(stderr, "generator_pool: Killing generator %d\n", (int)pool->generators[i].pid);
+					kill(pool->generators[i].pid, SIGKILL);
+					waitpid(pool->generators[i].pid, NULL, 0);
+					pool->generators[i].pid = 0;
+				}
+			}
+			pool->running = 0;
+		}else if(pool->running > 0){
+			usleep(10000);
+		}
+	}
+}
+
+void free_generator_pool(generator_pool_t *pool) {
+	free(pool->generators);
+	free(pool->argv);
+	free(pool->cpus);
+	free(pool);
+}
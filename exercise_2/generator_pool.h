@@ -0,0 +1,97 @@
+/**
+ * @file
+ * @brief generator_pool module starts generator processes for the supervisor and restarts them if they crash
+ *
+ * @autor Benjamin Deutsch (12215881)
+ * @date 16.11.2023
+ */
+#ifndef GENERATOR_POOL_H
+#define GENERATOR_POOL_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sys/types.h>
+#include "shared_buffer.h"
+
+#define POOL_FAST_CRASH_NS 1000000000L //a generator that crashes within a second after its start crashed fast
+#define POOL_MAX_FAST_CRASHES 3 //a generator that crashed fast this many times in a row is not restarted again
+#define POOL_STOP_TIMEOUT_MS 2000 //generators that did not quit after this time are killed
+
+/**
+ * @brief a generator process of the pool
+ * @details pid is 0 if the generator is not running. fast_crashes is the number of times in a row the generator
+ *          crashed shortly after it was started.
+ */
+typedef struct pool_generator {
+	pid_t pid;
+	struct timespec started;
+	int cpu;
+	int fast_crashes;
+} pool_generator_t;
+
+/**
+ * @brief a pool of generator processes that all run the same command
+ * @details argv is the null terminated argument vector the generators are executed with, its first entry is the
+ *          path of the generator. Every generator is pinned to its own cpu, cpus holds the cpus the supervisor may
+ *          run on. running is the number of generators that have not terminated yet and failed is the number of
+ *          generators that terminated with an error.
+ */
+typedef struct generator_pool {
+	pool_generator_t *generators;
+	size_t count;
+	char **argv;
+	int *cpus;
+	size_t cpu_count;
+	size_t running;
+	size_t failed;
+	unsigned long restarts;
+} generator_pool_t;
+
+/**
+ * @brief creates a pool of generators without starting them
+ * @param count the number of generators
+ * @param path the path of the generator executable, it is searched in PATH if it does not contain a slash
+ * @param args the arguments the generators are called with
+ * @param arg_count the number of arguments
+ * @return the pool or NULL if a memory allocation error occured
+ */
+generator_pool_t* create_generator_pool(size_t count, const char *path, char *const args[], size_t arg_count);
+
+/**
+ * @brief starts all generators of the pool
+ * @details the i-th generator is pinned to the i-th cpu the supervisor may run on, wrapping around if there are
+ *          more generators than cpus. The affinity is set in the child before it executes the generator.
+ * @param pool the pool
+ * @return 0 if all generators were started, -1 if a process could not be created
+ */
+int start_generators(generator_pool_t *pool);
+
+/**
+ * @brief reaps the terminated generators of the pool and restarts the ones that crashed
+ * @details never blocks. A generator that was killed by a signal is restarted on the same cpu, unless it crashed
+ *          fast POOL_MAX_FAST_CRASHES times in a row. A generator that exited is not restarted, because it either
+ *          finished its work or failed for a reason a restart would not fix. If a terminated generator held the
+ *          write semaphore of the shared buffer, the semaphore is released, and the work items of the exact solver
+ *          it had not finished are handed out to the other generators again.
+ * @param pool the pool
+ * @param data the shared data struct the generators write to
+ * @return 0 on success, -1 if a crashed generator could not be restarted
+ */
+int restart_crashed_generators(generator_pool_t *pool, shared_data_t *data);
+
+/**
+ * @brief waits for all generators of the pool to terminate
+ * @details must be called after the quit flag was set and the waiting processes were released. Generators that
+ *          did not terminate after POOL_STOP_TIMEOUT_MS are killed.
+ * @param pool the pool
+ */
+void stop_generators(generator_pool_t *pool);
+
+/**
+ * @brief frees the memory of the given pool
+ * @param pool the pool
+ */
+void free_generator_pool(generator_pool_t *pool);
+
+#endif /* GENERATOR_POOL_H */
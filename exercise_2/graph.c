@@ -0,0 +1,247 @@
+#include "graph.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief fills the offsets and columns of one compressed sparse row direction of the graph
+ * @details counting sort of the edges by their row vertex, the relative order of the edges is kept.
+ * @param edge_count the number of edges
+ * @param vertex_count the number of vertices
+ * @param rows the row vertex of every edge
+ * @param columns the column vertex of every edge
+ * @param offsets the offsets array to be filled, vertex_count + 1 entries initialized with 0
+ * @param result the columns array to be filled, edge_count entries
+ */
+static void fill_rows(size_t edge_count, size_t vertex_count, const uint32_t *rows, const uint32_t *columns,
+		size_t *offsets, uint32_t *result) {
+	size_t i;
+	for(i = 0; i < edge_count; i++){
+		offsets[rows[i] + 1]++;
+	}
+	for(i = 0; i < vertex_count; i++){
+		offsets[i + 1] += offsets[i];
+	}
+	//offsets[v] is used as insertion cursor and restored afterwards
+	for(i = 0; i < edge_count; i++){
+		result[offsets[rows[i]]++] = columns[i];
+	}
+	for(i = vertex_count; i > 0; i--){
+		offsets[i] = offsets[i - 1];
+	}
+	offsets[0] = 0;
+}
+
+graph_t* create_graph(const edge_t *edges, size_t edge_count) {
+	size_t i;
+	graph_t *graph = calloc(1, sizeof(graph_t));
+	if(graph == NULL){
+		perror("graph: Memory allocation error occured.");
+		return NULL;
+	}
+	graph->edge_count = edge_count;
+	graph->map = create_vertex_map(edge_count);
+	uint32_t *sources = malloc(edge_count * sizeof(uint32_t) + 1);
+	uint32_t *destinations = malloc(edge_count * sizeof(uint32_t) + 1);
+	if(graph->map == NULL || sources == NULL || destinations == NULL){
+		free(sources);
+		free(destinations);
+		free_graph(graph);
+		perror("graph: Memory allocation error occured.");
+		return NULL;
+	}
+	//first pass: assign the dense indices
+	for(i = 0; i < edge_count; i++){
+		long source = vertex_map_insert(graph->map, edges[i].source);
+		long destination = vertex_map_insert(graph->map, edges[i].destination);
+		if(source == -1 || destination == -1){
+			free(sources);
+			free(destinations);
+			free_graph(graph);
+			return NULL;
+		}
+		sources[i] = source;
+		destinations[i] = destination;
+	}
+	graph->vertex_count = graph->map->length;
+	graph->ids = malloc(graph->vertex_count * sizeof(int32_t) + 1);
+	graph->offsets = calloc(graph->vertex_count + 1, sizeof(size_t));
+	graph->targets = malloc(edge_count * sizeof(uint32_t) + 1);
+	graph->in_offsets = calloc(graph->vertex_count + 1, sizeof(size_t));
+	graph->sources = malloc(edge_count * sizeof(uint32_t) + 1);
+	if(graph->ids == NULL || graph->offsets == NULL || graph->targets == NULL ||
+			graph->in_offsets == NULL || graph->sources == NULL){
+		free(sources);
+		free(destinations);
+		free_graph(graph);
+		perror("graph: Memory allocation error occured.");
+		return NULL;
+	}
+	for(i = 0; i < edge_count; i++){
+		graph->ids[sources[i]] = edges[i].source;
+		graph->ids[destinations[i]] = edges[i].destination;
+	}
+	//second pass: fill the outgoing and the incoming edges
+	fill_rows(edge_count, graph->vertex_count, sources, destinations, graph->offsets, graph->targets);
+	fill_rows(edge_count, graph->vertex_count, destinations, sources, graph->in_offsets, graph->sources);
+	free(sources);
+	free(destinations);
+	return graph;
+}
+
+long graph_index_of(const graph_t *graph, int32_t vertex) {
+	return vertex_map_get(graph->map, vertex);
+}
+
+long find_components(const graph_t *graph, uint32_t *component) {
+	const uint32_t unvisited = UINT32_MAX;
+	size_t n = graph->vertex_count;
+	uint32_t *index = malloc(n * sizeof(uint32_t) + 1);
+	uint32_t *low = malloc(n * sizeof(uint32_t) + 1);
+	uint32_t *stack = malloc(n * sizeof(uint32_t) + 1);
+	uint32_t *calls = malloc(n * sizeof(uint32_t) + 1);
+	size_t *next_edge = malloc(n * sizeof(size_t) + 1);
+	if(index == NULL || low == NULL || stack == NULL || calls == NULL || next_edge == NULL){
+		free(index);
+		free(low);
+		free(stack);
+		free(calls);
+		free(next_edge);
+		perror("graph: Memory allocation error occured.");
+		return -1;
+	}
+	size_t v, stack_length = 0, call_length = 0;
+	uint32_t counter = 0, count = 0;
+	for(v = 0; v < n; v++){
+		index[v] = unvisited;
+		//component[v] == unvisited marks vertices that are on the stack
+		component[v] = unvisited;
+	}
+	for(v = 0; v < n; v++){
+		if(index[v] != unvisited){
+			continue;
+		}
+		index[v] = low[v] = counter++;
+		next_edge[v] = graph->offsets[v];
+		stack[stack_length++] = v;
+		calls[call_length++] = v;
+		while(call_length > 0){
+			uint32_t u = calls[call_length - 1];
+			if(next_edge[u] < graph->offsets[u+1]){
+				uint32_t w = graph->targets[next_edge[u]++];
+				if(index[w] == unvisited){
+					index[w] = low[w] = counter++;
+					next_edge[w] = graph->offsets[w];
+					stack[stack_length++] = w;
+					calls[call_length++] = w;
+				}else if(component[w] == unvisited && index[w] < low[u]){
+					low[u] = index[w];
+				}
+				continue;
+			}
+			call_length--;
+			if(call_length > 0 && low[u] < low[calls[call_length - 1]]){
+				low[calls[call_length - 1]] = low[u];
+			}
+			if(low[u] == index[u]){
+				uint32_t w;
+				do {
+					w = stack[--stack_length];
+					component[w] = count;
+				} while(w != u);
+				count++;
+			}
+		}
+	}
+	free(index);
+	free(low);
+	free(stack);
+	free(calls);
+	free(next_edge);
+	return count;
+}
+
+graph_t** split_components(const graph_t *graph, size_t *count) {
+	size_t v, e, c;
+	uint32_t *component = malloc(graph->vertex_count * sizeof(uint32_t) + 1);
+	if(component == NULL){
+		perror("graph: Memory allocation error occured.");
+		return NULL;
+	}
+	long component_count = find_components(graph, component);
+	if(component_count == -1){
+		free(component);
+		return NULL;
+	}
+	size_t *offsets = calloc(component_count + 1, sizeof(size_t));
+	edge_t *edges = malloc(graph->edge_count * sizeof(edge_t) + 1);
+	graph_t **components = malloc(component_count * sizeof(graph_t*) + 1);
+	if(offsets == NULL || edges == NULL || components == NULL){
+		free(component);
+		free(offsets);
+		free(edges);
+		free(components);
+		perror("graph: Memory allocation error occured.");
+		return NULL;
+	}
+	//group the edges inside the components by their component
+	for(v = 0; v < graph->vertex_count; v++){
+		for(e = graph->offsets[v]; e < graph->offsets[v+1]; e++){
+			if(component[graph->targets[e]] == component[v]){
+				offsets[component[v] + 1]++;
+			}
+		}
+	}
+	for(c = 0; c < component_count; c++){
+		offsets[c + 1] += offsets[c];
+	}
+	for(v = 0; v < graph->vertex_count; v++){
+		for(e = graph->offsets[v]; e < graph->offsets[v+1]; e++){
+			if(component[graph->targets[e]] == component[v]){
+				edge_t *edge = &edges[offsets[component[v]]++];
+				edge->source = graph->ids[v];
+				edge->destination = graph->ids[graph->targets[e]];
+			}
+		}
+	}
+	//offsets[c] is now the end of the edges of component c
+	*count = 0;
+	size_t start = 0;
+	for(c = 0; c < component_count; c++){
+		if(offsets[c] > start){
+			components[*count] = create_graph(edges + start, offsets[c] - start);
+			if(components[*count] == NULL){
+				break;
+			}
+			(*count)++;
+		}
+		start = offsets[c];
+	}
+	free(component);
+	free(offsets);
+	free(edges);
+	if(c < component_count){
+		free_components(components, *count);
+		return NULL;
+	}
+	return components;
+}
+
+void free_components(graph_t **components, size_t count) {
+	size_t c;
+	for(c = 0; c < count; c++){
+		free_graph(components[c]);
+	}
+	free(components);
+}
+
+void free_graph(graph_t *graph) {
+	if(graph->map != NULL){
+		free_vertex_map(graph->map);
+	}
+	free(graph->ids);
+	free(graph->offsets);
+	free(graph->targets);
+	free(graph->in_offsets);
+	free(graph->sources);
+	free(graph);
+}
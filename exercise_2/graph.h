@@ -0,0 +1,92 @@
+/**
+ * @file
+ * @brief graph module provides an immutable compressed sparse row representation of a directed graph
+ *
+ * @autor Benjamin Deutsch (12215881)
+ * @date 16.11.2023
+ */
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "edge.h"
+#include "vertex_map.h"
+
+/**
+ * @brief stores a directed graph in compressed sparse row form
+ * @details the vertices are remapped to the dense indices 0..vertex_count-1, ids[i] is the original id of the
+ *          vertex with the index i. The destinations of the edges that originate from the vertex with the index i
+ *          are stored in targets[offsets[i]] to targets[offsets[i+1]-1], so iterating over the edges of a vertex
+ *          is a walk over a contiguous array. The incoming edges are stored the same way in in_offsets and
+ *          sources, so that algorithms that move single vertices can visit all of their edges in O(deg).
+ *          The map is used to look up the index of a vertex id in O(1).
+ */
+typedef struct graph {
+	size_t vertex_count;
+	size_t edge_count;
+	int32_t *ids;
+	size_t *offsets;
+	uint32_t *targets;
+	size_t *in_offsets;
+	uint32_t *sources;
+	vertex_map_t *map;
+} graph_t;
+
+/**
+ * @brief creates a graph from the given edges
+ * @details the graph is built in two passes over the edges: the first pass assigns the dense indices and counts
+ *          the edges of each vertex, the second pass fills the targets and sources arrays. The order of the edges
+ *          of a vertex is the order in which they appear in the given array.
+ * @param edges the edges of the graph
+ * @param edge_count the number of edges
+ * @return NULL if a memory allocation error occured, the graph otherwise
+ */
+graph_t* create_graph(const edge_t *edges, size_t edge_count);
+
+/**
+ * @brief returns the dense index of the vertex with the given id
+ * @param graph the graph that the vertex should be searched in
+ * @param vertex the id of the vertex
+ * @return the index of the vertex if the graph contains the vertex, -1 otherwise
+ */
+long graph_index_of(const graph_t *graph, int32_t vertex);
+
+/**
+ * @brief computes the strongly connected components of the given graph
+ * @details implements Tarjan's algorithm without recursion, so deep graphs can not overflow the stack. The
+ *          components are numbered in reverse topological order, i.e. no edge leads from a component to a
+ *          component with a larger number.
+ * @param graph the graph whose components should be computed
+ * @param component the array that the component number of every vertex should be written into, has to be able to
+ *                  hold vertex_count entries
+ * @return the number of components or -1 if a memory allocation error occured
+ */
+long find_components(const graph_t *graph, uint32_t *component);
+
+/**
+ * @brief splits the given graph into the subgraphs of its strongly connected components that contain edges
+ * @details only edges inside a strongly connected component can lie on a cycle, so the feedback arc sets of the
+ *          graph are exactly the unions of feedback arc sets of these subgraphs. Edges between components and
+ *          components without edges are dropped. The vertices keep their original ids but get new dense indices.
+ *          The subgraphs are built in one pass over the edges, O(V+E) in total.
+ * @param graph the graph
+ * @param count the number of subgraphs is written into this parameter, 0 if the graph is acyclic
+ * @return NULL if a memory allocation error occured, the array of subgraphs otherwise
+ */
+graph_t** split_components(const graph_t *graph, size_t *count);
+
+/**
+ * @brief frees the given subgraphs and the array that contains them
+ * @param components the subgraphs as returned by split_components
+ * @param count the number of subgraphs
+ */
+void free_components(graph_t **components, size_t count);
+
+/**
+ * @brief frees all of the dynamically allocated memory of the given graph, including the graph itself
+ * @param graph the graph to be freed
+ */
+void free_graph(graph_t *graph);
+
+#endif /* GRAPH_H */
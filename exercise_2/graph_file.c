@@ -0,0 +1,244 @@
+#include "graph_file.h"
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define READ_CHUNK_SIZE 65536
+
+/**
+ * @brief reads everything from the given file descriptor into a heap buffer
+ * @param fd the file descriptor
+ * @param size the number of read bytes is written to this address
+ * @return the buffer, which has to be freed by the caller, or NULL if an error occured
+ */
+static char* read_all(int fd, size_t *size) {
+	size_t capacity = READ_CHUNK_SIZE, length = 0;
+	char *buffer = malloc(capacity);
+	if(buffer == NULL){
+		perror("graph_file: Memory allocation error occured.");
+		return NULL;
+	}
+	while(true){
+		if(length == capacity){
+			char *grown = realloc(buffer, capacity * 2);
+			if(grown == NULL){
+				free(buffer);
+				perror("graph_file: Memory allocation error occured.");
+				return NULL;
+			}
+			buffer = grown;
+			capacity *= 2;
+		}
+		ssize_t count = read(fd, buffer + length, capacity - length);
+		if(count == 0){
+			break;
+		}
+		if(count == -1){
+			free(buffer);
+			perror("graph_file: Error reading input");
+			return NULL;
+		}
+		length += count;
+	}
+	*size = length;
+	return buffer;
+}
+
+/**
+ * @brief parses a decimal 32 bit integer with an optional leading minus
+ * @param text the position of the first character, is moved behind the parsed number
+ * @param end the end of the text
+ * @param value the parsed value is written to this address
+ * @return 0 on success, -1 if there is no valid number at the position
+ */
+static int parse_int(const char **text, const char *end, int32_t *value) {
+	const char *position = *text;
+	bool negative = false;
+	if(position < end && *position == '-'){
+		negative = true;
+		position++;
+	}
+	if(position == end || !isdigit((unsigned char)*position)){
+		return -1;
+	}
+	int64_t result = 0;
+	while(position < end && isdigit((unsigned char)*position)){
+		result = result * 10 + (*position - '0');
+		if(result > (int64_t)INT32_MAX + 1){
+			return -1;
+		}
+		position++;
+	}
+	if(negative){
+		result = -result;
+	}
+	if(result > INT32_MAX){
+		return -1;
+	}
+	*value = result;
+	*text = position;
+	return 0;
+}
+
+edge_t* parse_edge_text(const char *text, size_t length, size_t *count) {
+	const char *end = text + length;
+	size_t capacity = 1024, edge_count = 0;
+	edge_t *edges = malloc(capacity * sizeof(edge_t));
+	if(edges == NULL){
+		perror("graph_file: Memory allocation error occured.");
+		return NULL;
+	}
+	while(true){
+		while(text < end && (isspace((unsigned char)*text) || *text == '#')){
+			if(*text == '#'){
+				while(text < end && *text != '\n'){
+					text++;
+				}
+			}else{
+				text++;
+			}
+		}
+		if(text == end){
+			break;
+		}
+		edge_t edge;
+		if(parse_int(&text, end, &edge.source) == -1 || text == end || *text++ != '-' ||
+				parse_int(&text, end, &edge.destination) == -1 ||
+				(text < end && !isspace((unsigned char)*text) && *text != '#')){
+			free(edges);
+			fprintf(stderr, "graph_file: Invalid edge in input\n");
+			return NULL;
+		}
+		if(edge_count == capacity){
+			edge_t *grown = realloc(edges, capacity * 2 * sizeof(edge_t));
+			if(grown == NULL){
+				free(edges);
+				perror("graph_file: Memory allocation error occured.");
+				return NULL;
+			}
+			edges = grown;
+			capacity *= 2;
+		}
+		edges[edge_count++] = edge;
+	}
+	*count = edge_count;
+	return edges;
+}
+
+/**
+ * @brief sets the edges of the list to the content of its data
+ * @details binary graph files are used in place, text files are parsed into a separate array.
+ * @param list the edge list with data and data_size set
+ * @return 0 on success, -1 if the content is invalid
+ */
+static int read_edges(edge_list_t *list) {
+	const graph_file_header_t *header = list->data;
+	if(list->data_size >= sizeof(graph_file_header_t) &&
+			memcmp(header->magic, GRAPH_FILE_MAGIC, sizeof(header->magic)) == 0){
+		if(header->version != GRAPH_FILE_VERSION){
+			fprintf(stderr, "graph_file: Unsupported graph file version %u\n", header->version);
+			return -1;
+		}
+		if(header->edge_count > (list->data_size - sizeof(graph_file_header_t)) / sizeof(edge_t)){
+			fprintf(stderr, "graph_file: Graph file is truncated\n");
+			return -1;
+		}
+		list->edges = (const edge_t*)(header + 1);
+		list->edge_count = header->edge_count;
+		return 0;
+	}
+	list->parsed = parse_edge_text(list->data, list->data_size, &list->edge_count);
+	if(list->parsed == NULL){
+		return -1;
+	}
+	list->edges = list->parsed;
+	return 0;
+}
+
+int load_graph_file(const char *path, edge_list_t *list) {
+	memset(list, 0, sizeof(edge_list_t));
+	if(strcmp(path, "-") == 0){
+		list->data = read_all(STDIN_FILENO, &list->data_size);
+		if(list->data == NULL){
+			return -1;
+		}
+	}else{
+		int fd = open(path, O_RDONLY);
+		if(fd == -1){
+			perror("graph_file: Error opening graph file");
+			return -1;
+		}
+		struct stat info;
+		if(fstat(fd, &info) == -1){
+			perror("graph_file: Error reading graph file");
+			close(fd);
+			return -1;
+		}
+		list->data_size = info.st_size;
+		if(S_ISREG(info.st_mode) && list->data_size > 0){
+			list->data = mmap(NULL, list->data_size, PROT_READ, MAP_SHARED, fd, 0);
+			if(list->data == MAP_FAILED){
+				list->data = NULL;
+				perror("graph_file: Error mapping graph file");
+				close(fd);
+				return -1;
+			}
+			list->mapped = true;
+		}else{
+			//pipes and empty files can not be mapped
+			list->data = read_all(fd, &list->data_size);
+		}
+		close(fd);
+		if(list->data == NULL){
+			return -1;
+		}
+	}
+	if(read_edges(list) == -1){
+		free_edge_list(list);
+		return -1;
+	}
+	if(list->parsed != NULL && list->mapped){
+		//the text is not needed anymore once it is parsed
+		munmap(list->data, list->data_size);
+		list->data = NULL;
+		list->mapped = false;
+	}
+	return 0;
+}
+
+int write_graph_file(const char *path, const edge_t *edges, size_t count) {
+	FILE *file = fopen(path, "wb");
+	if(file == NULL){
+		perror("graph_file: Error opening graph file");
+		return -1;
+	}
+	graph_file_header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, GRAPH_FILE_MAGIC, sizeof(header.magic));
+	header.version = GRAPH_FILE_VERSION;
+	header.edge_count = count;
+	if(fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(edges, sizeof(edge_t), count, file) != count){
+		perror("graph_file: Error writing graph file");
+		fclose(file);
+		return -1;
+	}
+	if(fclose(file) == EOF){
+		perror("graph_file: Error writing graph file");
+		return -1;
+	}
+	return 0;
+}
+
+void free_edge_list(edge_list_t *list) {
+	if(list->mapped){
+		munmap(list->data, list->data_size);
+	}else{
+		free(list->data);
+	}
+	free(list->parsed);
+	memset(list, 0, sizeof(edge_list_t));
+}
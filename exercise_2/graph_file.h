@@ -0,0 +1,82 @@
+/**
+ * @file
+ * @brief graph file module reads and writes edge lists in a binary and a text format
+ *
+ * @autor Benjamin Deutsch (12215881)
+ * @date 16.11.2023
+ */
+#ifndef GRAPH_FILE_H
+#define GRAPH_FILE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "edge.h"
+
+#define GRAPH_FILE_MAGIC "FASG"
+#define GRAPH_FILE_VERSION 1
+
+/**
+ * @brief the header of a binary graph file
+ * @details the header is followed by edge_count edges in the memory layout of edge_t. All numbers are stored in
+ *          the byte order of the machine that wrote the file, a file with a different version is rejected.
+ */
+typedef struct graph_file_header {
+	char magic[4];
+	uint32_t version;
+	uint64_t edge_count;
+} graph_file_header_t;
+
+/**
+ * @brief the edges of a loaded graph file
+ * @details edges points either into data, if the file is a binary graph file, or to parsed, if it is a text file.
+ *          data is the content of the file, which is mapped read-only if mapped is true, so that all processes
+ *          that load the same binary file read it from the page cache without copying or parsing it. The pages are
+ *          only shared while the list exists, the graph a process builds from the edges is its own copy.
+ */
+typedef struct edge_list {
+	const edge_t *edges;
+	size_t edge_count;
+	void *data;
+	size_t data_size;
+	bool mapped;
+	edge_t *parsed;
+} edge_list_t;
+
+/**
+ * @brief loads the edges of the given file
+ * @details the format is detected from the first bytes of the file. A binary graph file is mapped into memory
+ *          without copying the edges. Any other file is parsed as a text edge list: edges are written as
+ *          [int]-[int] and separated by whitespace, everything from a # to the end of the line is ignored.
+ * @param path the path of the file, - reads the file from stdin
+ * @param list the edge list that should be filled
+ * @return 0 on success, -1 if the file could not be read or is invalid
+ */
+int load_graph_file(const char *path, edge_list_t *list);
+
+/**
+ * @brief parses a text edge list
+ * @param text the text, which does not need to be null terminated
+ * @param length the length of the text
+ * @param count the number of parsed edges is written to this address
+ * @return the parsed edges, which have to be freed by the caller, or NULL if the text is invalid or a memory
+ *         allocation error occured
+ */
+edge_t* parse_edge_text(const char *text, size_t length, size_t *count);
+
+/**
+ * @brief writes the given edges into a binary graph file
+ * @param path the path of the file
+ * @param edges the edges
+ * @param count the number of edges
+ * @return 0 on success, -1 if the file could not be written
+ */
+int write_graph_file(const char *path, const edge_t *edges, size_t count);
+
+/**
+ * @brief frees the memory of the given edge list
+ * @param list the edge list
+ */
+void free_edge_list(edge_list_t *list);
+
+#endif /* GRAPH_FILE_H */
@@ -0,0 +1,39 @@
+/**
+ * @file
+ * @brief graphconv module converts text edge lists into binary graph files for the generator
+ *
+ * @autor Benjamin Deutsch (12215881)
+ * @date 16.11.2023
+ */
+#include "graph_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief prints the usage message for graphconv
+ */
+static void print_usage_message(void) {
+	fprintf(stderr, "USAGE: graphconv INPUT OUTPUT\n");
+}
+
+/**
+ * @brief converts a graph file into a binary graph file
+ * @details the input can be a text edge list or a binary graph file, the output is always a binary graph file,
+ *          which generators can map without parsing it.
+ * @param argc the number of arguments
+ * @param argv the path of the input file, - reads it from stdin, and the path of the output file
+ * @return EXIT_SUCCESS if the programm executed successfully, EXIT_FAILURE otherwise
+ */
+int main(int argc, char *argv[]) {
+	if(argc != 3){
+		print_usage_message();
+		return EXIT_FAILURE;
+	}
+	edge_list_t list;
+	if(load_graph_file(argv[1], &list) == -1){
+		return EXIT_FAILURE;
+	}
+	int result = write_graph_file(argv[2], list.edges, list.edge_count);
+	free_edge_list(&list);
+	return result == -1 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
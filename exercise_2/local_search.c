@@ -0,0 +1,334 @@
+#include "local_search.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#define NONE UINT32_MAX
+#define SINKS 0
+#define SOURCES 1
+#define FIRST_BUCKET 2
+#define KEY_GAP ((uint64_t)1 << 32) //the gap between the keys of neighbouring vertices after the keys are renumbered
+
+local_search_t* create_local_search(const graph_t *graph) {
+	size_t v, n = graph->vertex_count;
+	local_search_t *search = calloc(1, sizeof(local_search_t));
+	if(search == NULL){
+		perror("local_search: Memory allocation error occured.");
+		return NULL;
+	}
+	search->graph = graph;
+	for(v = 0; v < n; v++){
+		size_t degree = (graph->offsets[v+1] - graph->offsets[v]) + (graph->in_offsets[v+1] - graph->in_offsets[v]);
+		if(degree > search->max_degree){
+			search->max_degree = degree;
+		}
+	}
+	search->out_degree = malloc(n * sizeof(uint32_t) + 1);
+	search->in_degree = malloc(n * sizeof(uint32_t) + 1);
+	search->next = malloc(n * sizeof(uint32_t) + 1);
+	search->previous = malloc(n * sizeof(uint32_t) + 1);
+	search->list = malloc(n * sizeof(uint32_t) + 1);
+	search->key = malloc(n * sizeof(uint64_t) + 1);
+	search->heads = malloc((2 * search->max_degree + 1 + FIRST_BUCKET) * sizeof(uint32_t));
+	search->events = malloc(search->max_degree * sizeof(rank_event_t) + 1);
+	if(search->out_degree == NULL || search->in_degree == NULL || search->next == NULL || search->previous == NULL ||
+			search->list == NULL || search->heads == NULL || search->key == NULL || search->events == NULL){
+		free_local_search(search);
+		perror("local_search: Memory allocation error occured.");
+		return NULL;
+	}
+	return search;
+}
+
+/**
+ * @brief returns the list that the given vertex belongs to according to its remaining degrees
+ * @param search the working memory
+ * @param v the vertex
+ * @return SINKS, SOURCES or the bucket of the difference of out degree and in degree
+ */
+static uint32_t list_of(const local_search_t *search, uint32_t v) {
+	if(search->out_degree[v] == 0){
+		return SINKS;
+	}
+	if(search->in_degree[v] == 0){
+		return SOURCES;
+	}
+	return FIRST_BUCKET + search->max_degree + search->out_degree[v] - search->in_degree[v];
+}
+
+/**
+ * @brief removes the given vertex from its list
+ * @param search the working memory
+ * @param v the vertex
+ */
+static void unlink_vertex(local_search_t *search, uint32_t v) {
+	if(search->previous[v] == NONE){
+		search->heads[search->list[v]] = search->next[v];
+	}else{
+		search->next[search->previous[v]] = search->next[v];
+	}
+	if(search->next[v] != NONE){
+		search->previous[search->next[v]] = search->previous[v];
+	}
+}
+
+/**
+ * @brief inserts the given vertex at the front of the given list
+ * @param search the working memory
+ * @param v the vertex
+ * @param list the list
+ */
+static void link_vertex(local_search_t *search, uint32_t v, uint32_t list) {
+	search->list[v] = list;
+	search->previous[v] = NONE;
+	search->next[v] = search->heads[list];
+	if(search->heads[list] != NONE){
+		search->previous[search->heads[list]] = v;
+	}
+	search->heads[list] = v;
+}
+
+void greedy_order(local_search_t *search, sampler_t *sampler) {
+	const graph_t *graph = search->graph;
+	size_t i, e, n = graph->vertex_count;
+	size_t list_count = 2 * search->max_degree + 1 + FIRST_BUCKET;
+	for(i = 0; i < list_count; i++){
+		search->heads[i] = NONE;
+	}
+	for(i = 0; i < n; i++){
+		uint32_t v = sampler->order[n - 1 - i];
+		search->out_degree[v] = 0;
+		search->in_degree[v] = 0;
+		for(e = graph->offsets[v]; e < graph->offsets[v+1]; e++){
+			search->out_degree[v] += graph->targets[e] != v;
+		}
+		for(e = graph->in_offsets[v]; e < graph->in_offsets[v+1]; e++){
+			search->in_degree[v] += graph->sources[e] != v;
+		}
+	}
+	//link in reverse order, so the vertex that comes first in the current order is at the head of its list
+	size_t max_list = FIRST_BUCKET;
+	for(i = 0; i < n; i++){
+		uint32_t v = sampler->order[n - 1 - i];
+		uint32_t list = list_of(search, v);
+		link_vertex(search, v, list);
+		if(list > max_list){
+			max_list = list;
+		}
+	}
+	size_t front = 0, back = n;
+	while(front < back){
+		uint32_t v;
+		if(search->heads[SINKS] != NONE){
+			v = search->heads[SINKS];
+			sampler->order[--back] = v;
+		}else{
+			if(search->heads[SOURCES] != NONE){
+				v = search->heads[SOURCES];
+			}else{
+				while(search->heads[max_list] == NONE){
+					max_list--;
+				}
+				v = search->heads[max_list];
+			}
+			sampler->order[front++] = v;
+		}
+		unlink_vertex(search, v);
+		search->list[v] = NONE;
+		//update the degrees of the remaining neighbours
+		for(e = graph->offsets[v]; e < graph->offsets[v+1]; e++){
+			uint32_t w = graph->targets[e];
+			if(w != v && search->list[w] != NONE){
+				search->in_degree[w]--;
+				uint32_t list = list_of(search, w);
+				if(list != search->list[w]){
+					unlink_vertex(search, w);
+					link_vertex(search, w, list);
+					if(list > max_list){
+						max_list = list;
+					}
+				}
+			}
+		}
+		for(e = graph->in_offsets[v]; e < graph->in_offsets[v+1]; e++){
+			uint32_t u = graph->sources[e];
+			if(u != v && search->list[u] != NONE){
+				search->out_degree[u]--;
+				uint32_t list = list_of(search, u);
+				if(list != search->list[u]){
+					unlink_vertex(search, u);
+					link_vertex(search, u, list);
+				}
+			}
+		}
+	}
+	for(i = 0; i < n; i++){
+		sampler->position[sampler->order[i]] = i;
+	}
+}
+
+/**
+ * @brief compares two rank events by their key
+ * @param a the first event
+ * @param b the second event
+ * @return a negative number, 0 or a positive number if the key of a is smaller, equal or larger than the key of b
+ */
+static int compare_events(const void *a, const void *b) {
+	uint64_t x = ((const rank_event_t*)a)->key, y = ((const rank_event_t*)b)->key;
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief gives the vertices keys KEY_GAP apart in the order of the linked list
+ * @param search the working memory
+ */
+static void renumber_keys(local_search_t *search) {
+	uint32_t v;
+	uint64_t key = KEY_GAP;
+	for(v = search->first; v != NONE; v = search->next[v]){
+		search->key[v] = key;
+		key += KEY_GAP;
+	}
+}
+
+/**
+ * @brief moves the given vertex behind the given vertex in the linked order and gives it a key between its new
+ *        neighbours, renumbering all keys if there is none left between them
+ * @param search the working memory
+ * @param v the vertex
+ * @param target the vertex that v is put behind, NONE to put v at the front
+ */
+static void move_vertex(local_search_t *search, uint32_t v, uint32_t target) {
+	if(search->previous[v] == NONE){
+		search->first = search->next[v];
+	}else{
+		search->next[search->previous[v]] = search->next[v];
+	}
+	if(search->next[v] != NONE){
+		search->previous[search->next[v]] = search->previous[v];
+	}
+	uint32_t after = target == NONE ? search->first : search->next[target];
+	search->previous[v] = target;
+	search->next[v] = after;
+	if(target == NONE){
+		search->first = v;
+	}else{
+		search->next[target] = v;
+	}
+	if(after != NONE){
+		search->previous[after] = v;
+	}
+	uint64_t lower = target == NONE ? 0 : search->key[target];
+	if(after == NONE && lower <= UINT64_MAX - KEY_GAP){
+		search->key[v] = lower + KEY_GAP;
+	}else if(after != NONE && search->key[after] - lower >= 2){
+		search->key[v] = lower + (search->key[after] - lower) / 2;
+	}else{
+		renumber_keys(search);
+	}
+}
+
+/**
+ * @brief finds the best position of the given vertex and moves it there if that reduces the backward edges
+ * @details v can be put behind any of its neighbours or at the front, the positions between two neighbours that
+ *          are next to each other in the order all have the same cost. If v is put behind the neighbour with key k,
+ *          an outgoing edge is a backward edge if the key of its destination is at most k and an incoming edge is a
+ *          backward edge if the key of its source is larger than k.
+ * @param search the working memory
+ * @param v the vertex to move
+ * @return the reduction of the number of backward edges, 0 if the vertex was not moved
+ */
+static size_t sift_vertex(local_search_t *search, uint32_t v) {
+	const graph_t *graph = search->graph;
+	uint64_t current = search->key[v];
+	size_t e, i, count = 0;
+	long cost = 0, current_cost = 0;
+	for(e = graph->offsets[v]; e < graph->offsets[v+1]; e++){
+		uint32_t w = graph->targets[e];
+		if(w != v){
+			search->events[count].key = search->key[w];
+			search->events[count].vertex = w;
+			search->events[count].delta = 1;
+			current_cost += search->key[w] < current;
+			count++;
+		}
+	}
+	for(e = graph->in_offsets[v]; e < graph->in_offsets[v+1]; e++){
+		uint32_t u = graph->sources[e];
+		if(u != v){
+			search->events[count].key = search->key[u];
+			search->events[count].vertex = u;
+			search->events[count].delta = -1;
+			current_cost += search->key[u] > current;
+			cost++;
+			count++;
+		}
+	}
+	if(current_cost == 0){
+		return 0;
+	}
+	qsort(search->events, count, sizeof(rank_event_t), compare_events);
+	//cost is the number of backward edges of v at the front, each neighbour changes the cost of the positions after it
+	long best_cost = cost;
+	uint32_t best = NONE;
+	for(i = 0; i < count; i++){
+		cost += search->events[i].delta;
+		if((i + 1 == count || search->events[i+1].key != search->events[i].key) && cost < best_cost){
+			best_cost = cost;
+			best = search->events[i].vertex;
+		}
+	}
+	if(best_cost >= current_cost){
+		return 0;
+	}
+	move_vertex(search, v, best);
+	return current_cost - best_cost;
+}
+
+size_t improve_order(local_search_t *search, sampler_t *sampler) {
+	const graph_t *graph = search->graph;
+	size_t v, e, backward = 0;
+	for(v = 0; v < graph->vertex_count; v++){
+		for(e = graph->offsets[v]; e < graph->offsets[v+1]; e++){
+			if(sampler->position[v] >= sampler->position[graph->targets[e]]){
+				backward++;
+			}
+		}
+	}
+	size_t i, n = graph->vertex_count;
+	search->first = n > 0 ? sampler->order[0] : NONE;
+	for(i = 0; i < n; i++){
+		search->previous[sampler->order[i]] = i > 0 ? sampler->order[i-1] : NONE;
+		search->next[sampler->order[i]] = i + 1 < n ? sampler->order[i+1] : NONE;
+	}
+	renumber_keys(search);
+	bool improved = true;
+	while(improved && backward > 0){
+		improved = false;
+		for(v = 0; v < n; v++){
+			size_t reduction = sift_vertex(search, v);
+			if(reduction > 0){
+				backward -= reduction;
+				improved = true;
+			}
+		}
+	}
+	uint32_t w = search->first;
+	for(i = 0; i < n; i++, w = search->next[w]){
+		sampler->order[i] = w;
+		sampler->position[w] = i;
+	}
+	return backward;
+}
+
+void free_local_search(local_search_t *search) {
+	free(search->out_degree);
+	free(search->in_degree);
+	free(search->next);
+	free(search->previous);
+	free(search->list);
+	free(search->heads);
+	free(search->key);
+	free(search->events);
+	free(search);
+}
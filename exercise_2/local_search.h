@@ -0,0 +1,85 @@
+/**
+ * @file
+ * @brief local_search module improves vertex orders of a graph to find small feedback arc sets
+ *
+ * @autor Benjamin Deutsch (12215881)
+ * @date 16.11.2023
+ */
+#ifndef LOCAL_SEARCH_H
+#define LOCAL_SEARCH_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "graph.h"
+#include "sampler.h"
+
+/**
+ * @brief a neighbour of a vertex that is sifted, the key is the position of the neighbour in the gapped order
+ */
+typedef struct rank_event {
+	uint64_t key;
+	uint32_t vertex;
+	int delta;
+} rank_event_t;
+
+/**
+ * @brief stores the preallocated working memory of the local search for one graph
+ * @details every thread needs its own local search. The arrays are sized for the graph when the local search is
+ *          created, so neither the greedy ordering nor the improvement allocate memory. next and previous link the
+ *          buckets of the greedy ordering and the order of the improvement, in which every vertex has a key that
+ *          grows along the order, with gaps between the keys.
+ */
+typedef struct local_search {
+	const graph_t *graph;
+	uint32_t *out_degree;
+	uint32_t *in_degree;
+	uint32_t *next;
+	uint32_t *previous;
+	uint32_t *list;
+	uint32_t *heads;
+	uint64_t *key;
+	uint32_t first;
+	size_t max_degree;
+	rank_event_t *events;
+} local_search_t;
+
+/**
+ * @brief creates the working memory of the local search for the given graph
+ * @param graph the graph, has to outlive the local search
+ * @return NULL if a memory allocation error occured, the local search otherwise
+ */
+local_search_t* create_local_search(const graph_t *graph);
+
+/**
+ * @brief replaces the order of the sampler with the greedy order of Eades, Lin and Smyth
+ * @details repeatedly removes sinks and puts them at the end of the order, removes sources and puts them at the
+ *          front of the order and otherwise puts the vertex with the largest difference of out degree and in degree
+ *          at the front. The vertices are kept in buckets by this difference, so the order is computed in O(V+E).
+ *          Ties are broken by the current order of the sampler, so shuffling the sampler before this function is
+ *          called results in different greedy orders.
+ * @param search the working memory
+ * @param sampler the sampler whose order should be replaced, its graph has to be the graph of the search
+ */
+void greedy_order(local_search_t *search, sampler_t *sampler);
+
+/**
+ * @brief improves the order of the sampler by moving single vertices to their best position until no move helps
+ * @details for every vertex the number of backward edges at every possible position is computed by sweeping over
+ *          the positions of its neighbours, which is O(deg log deg) because the neighbours are sorted by position.
+ *          A vertex is only moved if that strictly reduces the number of backward edges, which are counted
+ *          incrementally, so the search terminates. The order is kept as a linked list with gapped keys while it is
+ *          improved, so a move relinks the vertex in O(1) and only takes O(V) when the keys around the new position
+ *          have run out and all keys are renumbered. The order of the sampler is written back at the end.
+ * @param search the working memory
+ * @param sampler the sampler whose order should be improved, its graph has to be the graph of the search
+ * @return the number of backward edges of the improved order, including self loops
+ */
+size_t improve_order(local_search_t *search, sampler_t *sampler);
+
+/**
+ * @brief frees all of the dynamically allocated memory of the given local search, including the local search itself
+ * @param search the local search to be freed
+ */
+void free_local_search(local_search_t *search);
+
+#endif /* LOCAL_SEARCH_H */
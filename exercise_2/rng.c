@@ -0,0 +1,70 @@
+#include "rng.h"
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief advances the given splitmix64 state and returns the next output
+ * @param x the state
+ * @return the next output
+ */
+static uint64_t splitmix64(uint64_t *x) {
+	uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/**
+ * @brief rotates the given value to the left
+ * @param x the value
+ * @param k the number of bits, 0 < k < 64
+ * @return the rotated value
+ */
+static uint64_t rotl(uint64_t x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+void rng_seed(rng_t *rng, uint64_t seed) {
+	int i;
+	for(i = 0; i < 4; i++){
+		rng->state[i] = splitmix64(&seed);
+	}
+}
+
+uint64_t rng_entropy_seed(void) {
+	static uint64_t counter = 0;
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	uint64_t seed = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+	seed ^= (uint64_t)getpid() << 32;
+	seed ^= __atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED) * 0xd1b54a32d192ed03ULL;
+	return splitmix64(&seed);
+}
+
+uint64_t rng_next(rng_t *rng) {
+	uint64_t *s = rng->state;
+	uint64_t result = rotl(s[1] * 5, 7) * 9;
+	uint64_t t = s[1] << 17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl(s[3], 45);
+	return result;
+}
+
+uint32_t rng_bounded(rng_t *rng, uint32_t bound) {
+	uint32_t x = rng_next(rng) >> 32;
+	uint64_t m = (uint64_t)x * bound;
+	uint32_t low = (uint32_t)m;
+	if(low < bound){
+		uint32_t threshold = -bound % bound;
+		while(low < threshold){
+			x = rng_next(rng) >> 32;
+			m = (uint64_t)x * bound;
+			low = (uint32_t)m;
+		}
+	}
+	return m >> 32;
+}
@@ -0,0 +1,52 @@
+/**
+ * @file
+ * @brief rng module provides a small and fast pseudo random number generator (xoshiro256**)
+ *
+ * @autor Benjamin Deutsch (12215881)
+ * @date 16.11.2023
+ */
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/**
+ * @brief the state of a xoshiro256** generator
+ * @details every thread should use its own state, the functions of this module do not synchronize.
+ */
+typedef struct rng {
+	uint64_t state[4];
+} rng_t;
+
+/**
+ * @brief seeds the generator with the given value
+ * @details the state is derived from the seed with splitmix64, so similar seeds result in unrelated streams.
+ * @param rng the generator to be seeded
+ * @param seed the seed
+ */
+void rng_seed(rng_t *rng, uint64_t seed);
+
+/**
+ * @brief returns a seed that differs between processes and calls, even if they are started in the same second
+ * @details combines the current time in nanoseconds, the process id and a per process call counter.
+ * @return the seed
+ */
+uint64_t rng_entropy_seed(void);
+
+/**
+ * @brief returns the next 64 bit random number of the given generator
+ * @param rng the generator
+ * @return a uniformly distributed 64 bit number
+ */
+uint64_t rng_next(rng_t *rng);
+
+/**
+ * @brief returns a uniformly distributed random number x with 0 <= x < bound
+ * @details uses Lemire's multiply and shift method, which avoids the division of the modulo operator and its bias.
+ * @param rng the generator
+ * @param bound the exclusive upper bound, has to be larger than 0
+ * @return the random number
+ */
+uint32_t rng_bounded(rng_t *rng, uint32_t bound);
+
+#endif /* RNG_H */
@@ -0,0 +1,132 @@
+#include "sampler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+sampler_t* create_sampler(const graph_t *graph) {
+	size_t i;
+	sampler_t *sampler = malloc(sizeof(sampler_t));
+	if(sampler == NULL){
+		perror("sampler: Memory allocation error occured.");
+		return NULL;
+	}
+	sampler->graph = graph;
+	sampler->order = malloc(graph->vertex_count * sizeof(uint32_t) + 1);
+	sampler->position = malloc(graph->vertex_count * sizeof(uint32_t) + 1);
+	if(sampler->order == NULL || sampler->position == NULL){
+		free_sampler(sampler);
+		perror("sampler: Memory allocation error occured.");
+		return NULL;
+	}
+	for(i = 0; i < graph->vertex_count; i++){
+		sampler->order[i] = i;
+		sampler->position[i] = i;
+	}
+	return sampler;
+}
+
+void shuffle_order(sampler_t *sampler, rng_t *rng) {
+	size_t i, length = sampler->graph->vertex_count;
+	uint32_t *order = sampler->order;
+	for(i = length; i > 1; i--) {
+		//generate a random number x < i
+		size_t x = rng_bounded(rng, i);
+		uint32_t swap = order[i-1];
+		order[i-1] = order[x];
+		order[x] = swap;
+	}
+	for(i = 0; i < length; i++){
+		sampler->position[order[i]] = i;
+	}
+}
+
+int seed_order(sampler_t *sampler, const edge_t *edges, size_t count) {
+	const graph_t *graph = sampler->graph;
+	size_t i, e, v, length = 0;
+	bool *removed = calloc(graph->edge_count + 1, sizeof(bool));
+	uint32_t *in_degree = calloc(graph->vertex_count + 1, sizeof(uint32_t));
+	if(removed == NULL || in_degree == NULL){
+		free(removed);
+		free(in_degree);
+		perror("sampler: Memory allocation error occured.");
+		return -1;
+	}
+	//every given edge removes one parallel edge of the graph
+	for(i = 0; i < count; i++){
+		long source = graph_index_of(graph, edges[i].source);
+		long destination = graph_index_of(graph, edges[i].destination);
+		if(source == -1 || destination == -1){
+			continue;
+		}
+		for(e = graph->offsets[source]; e < graph->offsets[source+1]; e++){
+			if(graph->targets[e] == destination && !removed[e]){
+				removed[e] = true;
+				break;
+			}
+		}
+	}
+	for(v = 0; v < graph->vertex_count; v++){
+		for(e = graph->offsets[v]; e < graph->offsets[v+1]; e++){
+			if(!removed[e] && graph->targets[e] != v){
+				in_degree[graph->targets[e]]++;
+			}
+		}
+	}
+	//Kahn's algorithm, the order array is used as the queue and position marks the queued vertices
+	for(v = 0; v < graph->vertex_count; v++){
+		sampler->position[v] = 0;
+		if(in_degree[v] == 0){
+			sampler->order[length++] = v;
+			sampler->position[v] = 1;
+		}
+	}
+	for(i = 0, v = 0; i < graph->vertex_count; i++){
+		if(i == length){
+			//the remaining vertices lie on cycles, the first of them is placed anyway
+			for(; sampler->position[v] != 0; v++);
+			sampler->order[length++] = v;
+			sampler->position[v] = 1;
+		}
+		uint32_t vertex = sampler->order[i];
+		for(e = graph->offsets[vertex]; e < graph->offsets[vertex+1]; e++){
+			uint32_t target = graph->targets[e];
+			if(!removed[e] && target != vertex && --in_degree[target] == 0 && sampler->position[target] == 0){
+				sampler->order[length++] = target;
+				sampler->position[target] = 1;
+			}
+		}
+	}
+	for(i = 0; i < graph->vertex_count; i++){
+		sampler->position[sampler->order[i]] = i;
+	}
+	free(removed);
+	free(in_degree);
+	return 0;
+}
+
+size_t collect_feedback_arcs(const sampler_t *sampler, edge_t *edges, size_t max_edges) {
+	const graph_t *graph = sampler->graph;
+	const uint32_t *position = sampler->position;
+	size_t v, e, count = 0;
+	for(v = 0; v < graph->vertex_count; v++){
+		uint32_t source_position = position[v];
+		for(e = graph->offsets[v]; e < graph->offsets[v+1]; e++){
+			uint32_t destination = graph->targets[e];
+			if(source_position >= position[destination]){
+				if(count == max_edges){
+					return max_edges + 1;
+				}
+				edges[count].source = graph->ids[v];
+				edges[count].destination = graph->ids[destination];
+				count++;
+			}
+		}
+	}
+	return count;
+}
+
+void free_sampler(sampler_t *sampler) {
+	free(sampler->order);
+	free(sampler->position);
+	free(sampler);
+}
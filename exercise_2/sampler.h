@@ -0,0 +1,77 @@
+/**
+ * @file
+ * @brief sampler module generates random feedback arc sets of a graph without allocating memory per sample
+ *
+ * @autor Benjamin Deutsch (12215881)
+ * @date 16.11.2023
+ */
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "edge.h"
+#include "graph.h"
+#include "rng.h"
+
+/**
+ * @brief stores a vertex order of a graph and the position of every vertex in that order
+ * @details order[i] is the index of the vertex at position i, position[v] is the position of the vertex with the
+ *          index v, so position[order[i]] == i holds for all i. Both arrays are allocated once when the sampler
+ *          is created and reused for every sample.
+ */
+typedef struct sampler {
+	const graph_t *graph;
+	uint32_t *order;
+	uint32_t *position;
+} sampler_t;
+
+/**
+ * @brief creates a sampler for the given graph
+ * @details the initial order is the identity. The graph is not copied and has to outlive the sampler.
+ * @param graph the graph whose feedback arc sets should be sampled
+ * @return NULL if a memory allocation error occured, the sampler otherwise
+ */
+sampler_t* create_sampler(const graph_t *graph);
+
+/**
+ * @brief shuffles the vertex order of the sampler randomly and updates the positions of the vertices
+ * @details implements the Fisher–Yates shuffle, the positions are computed once afterwards. O(V).
+ * @param sampler the sampler whose order should be shuffled
+ * @param rng the random number generator that should be used, usually owned by the calling thread
+ */
+void shuffle_order(sampler_t *sampler, rng_t *rng);
+
+/**
+ * @brief sets the vertex order of the sampler to a topological order of the graph without the given edges
+ * @details the edges are usually a feedback arc set of the graph, so the backward edges of the new order are a
+ *          subset of them. Edges that are not part of the graph are ignored, and if the graph without the edges is
+ *          not acyclic, the vertices on the remaining cycles are appended in the order of their indices. O(V+E) plus
+ *          the degrees of the sources of the given edges.
+ * @param sampler the sampler whose order should be set
+ * @param edges the edges that should be ignored, for example the feedback arc set of a checkpoint
+ * @param count the number of edges
+ * @return 0 on success, -1 if a memory allocation error occured
+ */
+int seed_order(sampler_t *sampler, const edge_t *edges, size_t count);
+
+/**
+ * @brief collects the backward edges of the current vertex order, which form a feedback arc set
+ * @details an edge is a backward edge if its source comes after its destination in the current order, self loops
+ *          are always backward edges. Removing all backward edges makes the graph acyclic. Walks over every edge at
+ *          most once, O(V+E), and stops as soon as more than max_edges backward edges were found.
+ * @param sampler the sampler whose current order should be used
+ * @param edges the buffer that the backward edges should be written into
+ * @param max_edges the maximum number of edges that should be written into the buffer
+ * @return the number of backward edges if it is at most max_edges, max_edges + 1 otherwise
+ */
+size_t collect_feedback_arcs(const sampler_t *sampler, edge_t *edges, size_t max_edges);
+
+/**
+ * @brief frees all of the dynamically allocated memory of the given sampler, including the sampler itself
+ * @details the graph of the sampler is not freed
+ * @param sampler the sampler to be freed
+ */
+void free_sampler(sampler_t *sampler);
+
+#endif /* SAMPLER_H */
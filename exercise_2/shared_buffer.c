@@ -4,16 +4,30 @@
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <semaphore.h>
 #include <fcntl.h>
 #include <string.h>
+#include <errno.h>
+#include <stddef.h>
+#include <time.h>
+#include <ctype.h>
+#include <signal.h>
 
-const char SHARED_MEMORY_KEY[] = "12215881_feedback_arc_set_shm";
-const char WRITE_SEMAPHORE_KEY[] = "12215881_feedback_arc_set_buffer_write";
-const char BUFFER_FREE_SEMAPHORE_KEY[] = "12215881_feedback_arc_set_buffer_free";
-const char BUFFER_USED_SEMAPHORE_KEY[] = "12215881_feedback_arc_set_buffer_used";
+#define KEY_PREFIX "12215881_feedback_arc_set"
+#define KEY_LENGTH (sizeof(KEY_PREFIX "_buffer_write") + MAX_INSTANCE_NAME_LENGTH + 1)
+
+char SHARED_MEMORY_KEY[KEY_LENGTH] = KEY_PREFIX "_shm";
+char WRITE_SEMAPHORE_KEY[KEY_LENGTH] = KEY_PREFIX "_buffer_write";
+char BUFFER_FREE_SEMAPHORE_KEY[KEY_LENGTH] = KEY_PREFIX "_buffer_free";
+char BUFFER_USED_SEMAPHORE_KEY[KEY_LENGTH] = KEY_PREFIX "_buffer_used";
 sem_t *write_sem = NULL, *free_sem = NULL, *used_sem = NULL;
 
+//every group of fields has to start on its own line, and so does the buffer
+typedef char shared_data_layout_check[offsetof(shared_data_t, write_pos) % SHARED_BUFFER_ALIGNMENT == 0 &&
+		offsetof(shared_data_t, read_pos) % SHARED_BUFFER_ALIGNMENT == 0 &&
+		offsetof(shared_data_t, buffer) % SHARED_BUFFER_ALIGNMENT == 0 ? 1 : -1];
+
 /**
  * @brief releases all of the processes waiting for the given semaphore by calling sem_post unit its value is non-negative
  * @param semaphore the semaphore whose value should be increased to be non-negative
@@ -32,15 +46,84 @@ static int release_semaphore(sem_t *semaphore) {
 	return 0;
 }
 
-int create_shared_memory(void) {
-	//create shared memory
-	int shmfd = shm_open(SHARED_MEMORY_KEY, O_RDWR | O_CREAT, 0600);
+int set_shared_instance(const char *instance) {
+	size_t i, length = strlen(instance);
+	if(length == 0 || length > MAX_INSTANCE_NAME_LENGTH){
+		fprintf(stderr, "shared_buffer: Instance names have to be 1 to %d characters long\n", MAX_INSTANCE_NAME_LENGTH);
+		return -1;
+	}
+	for(i = 0; i < length; i++){
+		if(!isalnum((unsigned char)instance[i]) && instance[i] != '_' && instance[i] != '-'){
+			fprintf(stderr, "shared_buffer: Instance names may only contain letters, digits, _ and -\n");
+			return -1;
+		}
+	}
+	snprintf(SHARED_MEMORY_KEY, KEY_LENGTH, "%s_%s_shm", KEY_PREFIX, instance);
+	snprintf(WRITE_SEMAPHORE_KEY, KEY_LENGTH, "%s_%s_buffer_write", KEY_PREFIX, instance);
+	snprintf(BUFFER_FREE_SEMAPHORE_KEY, KEY_LENGTH, "%s_%s_buffer_free", KEY_PREFIX, instance);
+	snprintf(BUFFER_USED_SEMAPHORE_KEY, KEY_LENGTH, "%s_%s_buffer_used", KEY_PREFIX, instance);
+	return 0;
+}
+
+/**
+ * @brief removes the shared memory of the instance if the supervisor that created it does not run anymore
+ * @details the process id of the supervisor is read from the existing shared memory. If the shared memory is too
+ *          small to contain it, the supervisor crashed while it created the shared memory.
+ * @return 0 if the stale shared memory was removed, -1 if the instance is in use or an error occured
+ */
+static int remove_stale_instance(void) {
+	int shmfd = shm_open(SHARED_MEMORY_KEY, O_RDONLY, 0600);
 	if(shmfd == -1){
 		perror("shared_buffer: Error opening shared memory");
 		return -1;
 	}
+	pid_t owner = 0;
+	ssize_t count = pread(shmfd, &owner, sizeof(pid_t), offsetof(shared_data_t, owner));
+	close(shmfd);
+	if(count == sizeof(pid_t) && owner > 0 && (kill(owner, 0) == 0 || errno == EPERM)){
+		fprintf(stderr, "shared_buffer: The instance is in use by supervisor %d\n", (int)owner);
+		return -1;
+	}
+	fprintf(stderr, "shared_buffer: Removing the stale instance of supervisor %d\n", (int)owner);
+	if(shm_unlink(SHARED_MEMORY_KEY) == -1 && errno != ENOENT){
+		perror("shared_buffer: Error unlinking shared memory");
+		return -1;
+	}
+	return 0;
+}
+
+int create_shared_memory(size_t capacity, size_t *size) {
+	//create shared memory, the instance belongs to this process if it is created exclusively
+	int shmfd = shm_open(SHARED_MEMORY_KEY, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if(shmfd == -1 && errno == EEXIST){
+		if(remove_stale_instance() == -1){
+			return -1;
+		}
+		shmfd = shm_open(SHARED_MEMORY_KEY, O_RDWR | O_CREAT | O_EXCL, 0600);
+	}
+	if(shmfd == -1){
+		perror("shared_buffer: Error opening shared memory");
+		return -1;
+	}
+	//semaphores of a crashed run may have outlived its shared memory
+	sem_unlink(WRITE_SEMAPHORE_KEY);
+	sem_unlink(BUFFER_FREE_SEMAPHORE_KEY);
+	sem_unlink(BUFFER_USED_SEMAPHORE_KEY);
 	//set shared memory size
-	if(ftruncate(shmfd, sizeof(shared_data_t)) < 0){
+	capacity -= capacity % SHARED_BUFFER_ALIGNMENT;
+	*size = sizeof(shared_data_t) + capacity;
+	if(ftruncate(shmfd, *size) < 0){
+		close(shmfd);
+		perror("shared_buffer: Error initializing shared memory");
+		return -1;
+	}
+	//initialize the buffer and the bound before the semaphores exist, generators can not open the shared memory before that
+	uint64_t initial_capacity = capacity;
+	int initial_best_size = (capacity - sizeof(solution_t)) / sizeof(edge_t) + 1;
+	pid_t owner = getpid();
+	if(pwrite(shmfd, &initial_capacity, sizeof(uint64_t), offsetof(shared_data_t, capacity)) != sizeof(uint64_t) ||
+			pwrite(shmfd, &initial_best_size, sizeof(int), offsetof(shared_data_t, best_size)) != sizeof(int) ||
+			pwrite(shmfd, &owner, sizeof(pid_t), offsetof(shared_data_t, owner)) != sizeof(pid_t)){
 		close(shmfd);
 		perror("shared_buffer: Error initializing shared memory");
 		return -1;
@@ -52,7 +135,7 @@ int create_shared_memory(void) {
 		perror("shared_buffer: Error creating semaphore");
 		return -1;
 	}
-	free_sem = sem_open(BUFFER_FREE_SEMAPHORE_KEY, O_CREAT | O_EXCL, 0600, DATA_SIZE);
+	free_sem = sem_open(BUFFER_FREE_SEMAPHORE_KEY, O_CREAT | O_EXCL, 0600, 0);
 	if(free_sem == SEM_FAILED){
 		close(shmfd);
 		sem_close(write_sem);
@@ -70,7 +153,7 @@ int create_shared_memory(void) {
 	return shmfd;
 }
 
-int init_shared_memory(void) {
+int init_shared_memory(size_t *size) {
 	int shmfd = shm_open(SHARED_MEMORY_KEY, O_RDWR, 0600);
 	if(shmfd == -1){
 		perror("shared_buffer: Error opening shared memory");
@@ -99,6 +182,15 @@ int init_shared_memory(void) {
 		return -1;
 	}
 	
+	//the semaphores are created after the size was set
+	struct stat info;
+	if(fstat(shmfd, &info) == -1){
+		close(shmfd);
+		close_semaphores();
+		perror("shared_buffer: Error initializing shared memory");
+		return -1;
+	}
+	*size = info.st_size;
 	return shmfd;
 }
 
@@ -149,60 +241,289 @@ int release_waiting_processes(void) {
 	return 0;
 }
 
-bool write_solution(shared_data_t* data, char *solution){
-	if(data->quit) {
-		return true;
+/**
+ * @brief returns the current value of the monotonic clock
+ * @return the value in nanoseconds
+ */
+static uint64_t now_ns(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/**
+ * @brief waits for the given semaphore and adds the time it was blocked to the given counter
+ * @details the clock is only read if the semaphore can not be taken right away.
+ * @param semaphore the semaphore
+ * @param wait_ns the counter in the shared memory
+ * @return the result of sem_wait
+ */
+static int timed_wait(sem_t *semaphore, uint64_t *wait_ns) {
+	if(sem_trywait(semaphore) == 0) {
+		return 0;
 	}
-	if(sem_wait(free_sem) < 0) {
-		perror("shared_buffer: Error waiting for free semaphore");
-		sem_post(free_sem);
-		return true;
+	if(errno != EAGAIN) {
+		return -1;
 	}
+	uint64_t start = now_ns();
+	int result = sem_wait(semaphore);
+	__atomic_fetch_add(wait_ns, now_ns() - start, __ATOMIC_RELAXED);
+	return result;
+}
+
+/**
+ * @brief returns the number of edges of the given solution that are stored in its record
+ * @param data the shared data struct that should be accessed
+ * @param size the size of the solution
+ * @return the number of stored edges
+ */
+static size_t stored_edges(const shared_data_t* data, uint32_t size) {
+	size_t max_edges = get_max_solution_size(data);
+	return size < max_edges ? size : max_edges;
+}
+
+/**
+ * @brief returns the number of bytes the record of a solution with the given number of stored edges takes up
+ * @param edges the number of stored edges
+ * @return the length of the record, including the padding up to the next multiple of SHARED_BUFFER_ALIGNMENT
+ */
+static size_t record_length(size_t edges) {
+	size_t length = sizeof(solution_t) + edges * sizeof(edge_t);
+	return length + (SHARED_BUFFER_ALIGNMENT - length % SHARED_BUFFER_ALIGNMENT) % SHARED_BUFFER_ALIGNMENT;
+}
+
+/**
+ * @brief copies bytes into the buffer starting at the given position, wrapping around the end of the buffer
+ * @param data the shared data struct that should be accessed
+ * @param position the position of the first byte
+ * @param source the bytes
+ * @param length the number of bytes, must not be larger than the capacity
+ */
+static void copy_to_buffer(shared_data_t* data, uint64_t position, const void *source, size_t length) {
+	size_t offset = position % data->capacity;
+	size_t first = data->capacity - offset < length ? data->capacity - offset : length;
+	memcpy(data->buffer + offset, source, first);
+	memcpy(data->buffer, (const unsigned char*)source + first, length - first);
+}
+
+/**
+ * @brief copies bytes out of the buffer starting at the given position, wrapping around the end of the buffer
+ * @param data the shared data struct that should be accessed
+ * @param position the position of the first byte
+ * @param destination the address the bytes should be copied to
+ * @param length the number of bytes, must not be larger than the capacity
+ */
+static void copy_from_buffer(const shared_data_t* data, uint64_t position, void *destination, size_t length) {
+	size_t offset = position % data->capacity;
+	size_t first = data->capacity - offset < length ? data->capacity - offset : length;
+	memcpy(destination, data->buffer + offset, first);
+	memcpy((unsigned char*)destination + first, data->buffer, length - first);
+}
+
+/**
+ * @brief waits until the buffer has room for a record of the given length
+ * @details must only be called while holding the write semaphore. The reader only posts the free semaphore if a
+ *          writer announced that it waits, so the semaphore does not count every read record.
+ * @param data the shared data struct that should be accessed
+ * @param length the length of the record
+ * @return 0 if there is enough room, -1 if the process should quit or an error occured
+ */
+static int wait_for_space(shared_data_t* data, size_t length) {
+	while(true) {
+		if(data->capacity - (data->write_pos - __atomic_load_n(&data->read_pos, __ATOMIC_SEQ_CST)) >= length) {
+			return 0;
+		}
+		//check again after announcing the wait, the reader might have freed space in between
+		__atomic_store_n(&data->space_waiting, true, __ATOMIC_SEQ_CST);
+		if(data->capacity - (data->write_pos - __atomic_load_n(&data->read_pos, __ATOMIC_SEQ_CST)) >= length) {
+			return 0;
+		}
+		if(timed_wait(free_sem, &data->free_wait_ns) < 0) {
+			perror("shared_buffer: Error waiting for free semaphore");
+			return -1;
+		}
+		if(data->quit) {
+			sem_post(free_sem);
+			return -1;
+		}
+	}
+}
+
+bool write_solution(shared_data_t* data, const solution_t *solution){
+	return write_solutions(data, &solution, 1);
+}
+
+/**
+ * @brief releases the write semaphore after the writer field was cleared
+ * @param data the shared data struct that should be accessed
+ * @return the result of sem_post
+ */
+static int release_writer(shared_data_t* data) {
+	__atomic_store_n(&data->writer, 0, __ATOMIC_RELAXED);
+	return sem_post(write_sem);
+}
+
+bool write_solutions(shared_data_t* data, const solution_t *const *solutions, size_t count){
+	size_t i;
 	if(data->quit) {
-		sem_post(free_sem);
 		return true;
 	}
 	if(sem_wait(write_sem) < 0) {
 		perror("shared_buffer: Error waiting for write semaphore");
-		sem_post(free_sem);
 		return true;
 	}
-	if(data->quit) {
-		sem_post(free_sem);
-		sem_post(write_sem);
-		return true;
-	};
-	strncpy(data->solutions[data->write_pos],solution,DATA_ENTRY_SIZE);
-	data->write_pos = (data->write_pos + 1) % DATA_SIZE;
-	if(sem_post(write_sem) < 0) {
-		perror("shared_buffer: Error posting write semaphore");
-		sem_post(used_sem);
-		return true;
+	__atomic_store_n(&data->writer, getpid(), __ATOMIC_RELAXED);
+	for(i = 0; i < count; i++) {
+		if(data->quit) {
+			release_writer(data);
+			return true;
+		}
+		size_t edges = stored_edges(data, solutions[i]->size);
+		if(wait_for_space(data, record_length(edges)) == -1) {
+			release_writer(data);
+			return true;
+		}
+		copy_to_buffer(data, data->write_pos, solutions[i], sizeof(solution_t));
+		copy_to_buffer(data, data->write_pos + sizeof(solution_t), solutions[i]->edges, edges * sizeof(edge_t));
+		__atomic_store_n(&data->write_pos, data->write_pos + record_length(edges), __ATOMIC_RELEASE);
+		if(sem_post(used_sem) < 0) {
+			perror("shared_buffer: Error posting used semaphore");
+			release_writer(data);
+			return true;
+		}
 	}
-	if(sem_post(used_sem) < 0) {
-		perror("shared_buffer: Error posting used semaphore");
+	if(release_writer(data) < 0) {
+		perror("shared_buffer: Error posting write semaphore");
 		return true;
 	}
 	return false;
 }
 
-char* read_solution(shared_data_t* data){
-	char *str = malloc(DATA_ENTRY_SIZE);
-	if(str == NULL){
+bool recover_writer(shared_data_t* data, pid_t pid){
+	pid_t expected = pid;
+	if(pid == 0 || !__atomic_compare_exchange_n(&data->writer, &expected, 0, false, __ATOMIC_RELAXED,
+			__ATOMIC_RELAXED)) {
+		return false;
+	}
+	if(sem_post(write_sem) < 0) {
+		perror("shared_buffer: Error posting write semaphore");
+	}
+	return true;
+}
+
+size_t get_max_solution_size(const shared_data_t* data){
+	return (data->capacity - sizeof(solution_t)) / sizeof(edge_t);
+}
+
+solution_t* create_solution(size_t max_edges){
+	solution_t *solution = malloc(sizeof(solution_t) + max_edges * sizeof(edge_t));
+	if(solution == NULL){
 		perror("shared_buffer: Memory allocation error");
-		return NULL;
 	}
-	if(sem_wait(used_sem) < 0) {
-		perror("shared_buffer: Error waiting for used semaphore");
-		free(str);
-		return NULL;
+	return solution;
+}
+
+int get_best_size(shared_data_t* data){
+	return __atomic_load_n(&data->best_size, __ATOMIC_ACQUIRE);
+}
+
+void set_best_size(shared_data_t* data, int best_size){
+	__atomic_store_n(&data->best_size, best_size, __ATOMIC_RELEASE);
+}
+
+bool get_publish_all(shared_data_t* data){
+	return __atomic_load_n(&data->publish_all, __ATOMIC_ACQUIRE);
+}
+
+void set_publish_all(shared_data_t* data, bool publish_all){
+	__atomic_store_n(&data->publish_all, publish_all, __ATOMIC_RELEASE);
+}
+
+void add_samples(shared_data_t* data, uint64_t count){
+	__atomic_add_fetch(&data->samples, count, __ATOMIC_RELAXED);
+}
+
+uint64_t get_samples(shared_data_t* data){
+	return __atomic_load_n(&data->samples, __ATOMIC_RELAXED);
+}
+
+unsigned int take_work_item(shared_data_t* data, unsigned int item_count, size_t *slot){
+	uint64_t owner = (uint64_t)getpid() << 32;
+	size_t i;
+	//items of terminated generators are taken first
+	for(i = 0; i < MAX_WORK_SLOTS; i++){
+		uint64_t expected = __atomic_load_n(&data->work_slots[i], __ATOMIC_ACQUIRE);
+		if((expected >> 32) == 0 && (expected & UINT32_MAX) != 0 && __atomic_compare_exchange_n(&data->work_slots[i],
+				&expected, owner | (expected & UINT32_MAX), false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)){
+			*slot = i;
+			return (expected & UINT32_MAX) - 1;
+		}
+	}
+	for(i = 0; i < MAX_WORK_SLOTS; i++){
+		uint64_t expected = 0;
+		if(__atomic_compare_exchange_n(&data->work_slots[i], &expected, owner, false, __ATOMIC_ACQ_REL,
+				__ATOMIC_RELAXED)){
+			break;
+		}
 	}
-	strncpy(str, data->solutions[data->read_pos],DATA_ENTRY_SIZE);
-	if(sem_post(free_sem) < 0) {
+	if(i == MAX_WORK_SLOTS){
+		fprintf(stderr, "shared_buffer: All work item slots are in use\n");
+		return item_count;
+	}
+	//the item is recorded before it is taken, so it is never lost if the process terminates in between
+	unsigned int item = __atomic_load_n(&data->next_item, __ATOMIC_RELAXED);
+	do {
+		if(item >= item_count){
+			__atomic_store_n(&data->work_slots[i], 0, __ATOMIC_RELEASE);
+			return item_count;
+		}
+		__atomic_store_n(&data->work_slots[i], owner | (item + 1), __ATOMIC_SEQ_CST);
+	} while(!__atomic_compare_exchange_n(&data->next_item, &item, item + 1, false, __ATOMIC_SEQ_CST,
+			__ATOMIC_RELAXED));
+	*slot = i;
+	return item;
+}
+
+void finish_work_item(shared_data_t* data, size_t slot){
+	__atomic_store_n(&data->work_slots[slot], 0, __ATOMIC_RELEASE);
+}
+
+unsigned int recover_work_items(shared_data_t* data, pid_t pid){
+	unsigned int recovered = 0;
+	size_t i;
+	for(i = 0; i < MAX_WORK_SLOTS; i++){
+		uint64_t slot = __atomic_load_n(&data->work_slots[i], __ATOMIC_ACQUIRE);
+		if(pid != 0 && (slot >> 32) == (uint64_t)pid){
+			__atomic_store_n(&data->work_slots[i], slot & UINT32_MAX, __ATOMIC_RELEASE);
+			recovered += (slot & UINT32_MAX) != 0;
+		}
+	}
+	return recovered;
+}
+
+void get_buffer_stats(shared_data_t* data, buffer_stats_t *stats){
+	stats->capacity = data->capacity;
+	//the read position never passes the write position, so it is read first
+	uint64_t read_pos = __atomic_load_n(&data->read_pos, __ATOMIC_ACQUIRE);
+	stats->used = __atomic_load_n(&data->write_pos, __ATOMIC_ACQUIRE) - read_pos;
+	stats->free_wait_ns = __atomic_load_n(&data->free_wait_ns, __ATOMIC_RELAXED);
+	stats->used_wait_ns = __atomic_load_n(&data->used_wait_ns, __ATOMIC_RELAXED);
+}
+
+int read_solution(shared_data_t* data, solution_t *solution){
+	if(timed_wait(used_sem, &data->used_wait_ns) < 0) {
+		if(errno != EINTR) {
+			perror("shared_buffer: Error waiting for used semaphore");
+		}
+		return -1;
+	}
+	copy_from_buffer(data, data->read_pos, solution, sizeof(solution_t));
+	size_t edges = stored_edges(data, solution->size);
+	copy_from_buffer(data, data->read_pos + sizeof(solution_t), solution->edges, edges * sizeof(edge_t));
+	__atomic_store_n(&data->read_pos, data->read_pos + record_length(edges), __ATOMIC_SEQ_CST);
+	if(__atomic_exchange_n(&data->space_waiting, false, __ATOMIC_SEQ_CST) && sem_post(free_sem) < 0) {
 		perror("shared_buffer: Error posting free semaphore");
-		free(str);
-		return NULL;
+		return -1;
 	}
-	data->read_pos = (data->read_pos + 1) % DATA_SIZE;
-	return str;
+	return 0;
 }
@@ -8,33 +8,148 @@
 #ifndef CIRCULAR_BUFFER_H
 #define CIRCULAR_BUFFER_H
 
+#include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "edge.h"
 
-#define DATA_SIZE 20
-#define DATA_ENTRY_SIZE 180 //large enough to store 8 pairs of ints (16 * 10 digits + 8 * "-" + 7 * " ")
+#ifndef SHARED_BUFFER_ALIGNMENT
+#define SHARED_BUFFER_ALIGNMENT 64 //the size of a cache line
+#endif
+#define SHARED_BUFFER_PADDING(size) (SHARED_BUFFER_ALIGNMENT - (size) % SHARED_BUFFER_ALIGNMENT)
+
+#define MAX_INSTANCE_NAME_LENGTH 64
+
+#define DEFAULT_BUFFER_CAPACITY 65536
+#define MIN_BUFFER_CAPACITY 256
+#define MAX_BUFFER_CAPACITY 1073741824
+
+#define MAX_WORK_SLOTS 1024 //the maximum number of work items of the exact solver that can be in progress at once
+
+#define SOLUTION_SAMPLE 0
+#define SOLUTION_EXACT 1
 
+/**
+ * @brief represents a feedback arc set solution in binary form
+ * @details size is the number of edges in the solution. The edges array holds the first size edges, but at most
+ *          get_max_solution_size of them, so a solution has to be allocated with create_solution. In the shared
+ *          memory every solution is stored as a record that consists of the header and exactly these edges, so
+ *          small solutions take up little space and reading the size of a solution is O(1).
+ *          Solutions of the kind SOLUTION_SAMPLE are feedback arc sets of the whole graph. Solutions of the kind
+ *          SOLUTION_EXACT are the result of one work item of the exact solver: the best solution of the strongly
+ *          connected component with the number component, out of component_count components, that the generator
+ *          knows of after it finished the item with the index item. item_count is the total number of work items.
+ *          generator is the process id of the generator that found the solution.
+ */
+typedef struct solution {
+	uint32_t size;
+	uint32_t generator;
+	uint32_t kind;
+	uint32_t component;
+	uint32_t component_count;
+	uint32_t item_count;
+	uint32_t item;
+	edge_t edges[];
+} solution_t;
+
+/**
+ * @brief the data in the shared memory
+ * @details buffer is a circular buffer of capacity bytes that contains the solution records. write_pos and
+ *          read_pos are the total number of bytes that have been written and read, the byte at a position is
+ *          buffer[position % capacity] and a record may wrap around the end of the buffer. The capacity is set
+ *          by create_shared_memory and never changes afterwards.
+ *          The fields are grouped by the processes that write them, and every group is padded to its own cache
+ *          line, so the supervisor reading solutions and the generators writing them do not invalidate each
+ *          other's lines when they update their positions. The buffer starts on a cache line and every record is
+ *          padded to a multiple of SHARED_BUFFER_ALIGNMENT bytes, so two records never share a line either.
+ *          best_size is the size of the best solution the supervisor has received so far, or the largest solution
+ *          that fits into the buffer plus one before the first solution was received. Generators only publish
+ *          solutions that are smaller. It is accessed with get_best_size and set_best_size only. If publish_all is
+ *          set, generators publish every solution regardless of best_size, so the supervisor sees all of them. It is
+ *          accessed with get_publish_all and set_publish_all only. samples is the number of samples the generators
+ *          have evaluated, including the ones they did not publish, it is accessed with add_samples and get_samples
+ *          only. next_item is the next work item of the exact solver that has not been taken by a generator yet.
+ *          work_slots records the items that are in progress: the upper 32 bits of a slot are the process id of the
+ *          generator that works on the item, the lower 32 bits the index of the item plus one. A slot without a
+ *          process id but with an item holds the item of a generator that terminated before it finished it, which is
+ *          handed out again.
+ *          next_item and work_slots are accessed with take_work_item, finish_work_item and recover_work_items only.
+ *          space_waiting is set by a writer that waits for the reader to free space.
+ *          free_wait_ns and used_wait_ns are the total nanoseconds that writers and the reader were blocked
+ *          because the buffer was full or empty. writer is the process id of the generator that holds the write
+ *          semaphore, or 0 if it is free. owner is the process id of the supervisor that created the shared
+ *          memory.
+ */
 typedef struct shared_data {
-	char solutions[DATA_SIZE][DATA_ENTRY_SIZE];
-	int write_pos;
-	int read_pos;
+	//written by the supervisor, read by the generators
+	uint64_t capacity;
+	int best_size;
+	pid_t owner;
 	bool quit;
+	bool publish_all;
+	char supervisor_padding[SHARED_BUFFER_PADDING(sizeof(uint64_t) + sizeof(int) + sizeof(pid_t) + 2 * sizeof(bool))];
+	//written by the generators
+	uint64_t write_pos;
+	uint64_t free_wait_ns;
+	uint64_t samples;
+	unsigned int next_item;
+	pid_t writer;
+	char generator_padding[SHARED_BUFFER_PADDING(3 * sizeof(uint64_t) + sizeof(unsigned int) + sizeof(pid_t))];
+	//written by the reader, and by a writer that waits for space
+	uint64_t read_pos;
+	uint64_t used_wait_ns;
+	bool space_waiting;
+	char reader_padding[SHARED_BUFFER_PADDING(2 * sizeof(uint64_t) + sizeof(bool))];
+	//written by the generators, and by the supervisor for generators that terminated
+	uint64_t work_slots[MAX_WORK_SLOTS];
+	unsigned char buffer[];
 } shared_data_t;
 
+/**
+ * @brief a snapshot of the state of the solution buffer
+ * @details used is the number of bytes of the buffer that are occupied by records that have not been read yet.
+ *          free_wait_ns and used_wait_ns are the total nanoseconds that writers and the reader were blocked
+ *          because the buffer was full or empty.
+ */
+typedef struct buffer_stats {
+	uint64_t used;
+	uint64_t capacity;
+	uint64_t free_wait_ns;
+	uint64_t used_wait_ns;
+} buffer_stats_t;
+
+/**
+ * @brief selects the instance whose shared memory and semaphores are used by all following calls
+ * @details every instance has its own shared memory and semaphores, so several supervisors with their generators
+ *          can run on the same host at the same time. Without a call to this function the default instance is used.
+ * @param instance the name of the instance, 1 to MAX_INSTANCE_NAME_LENGTH letters, digits, _ or -
+ * @return 0 on success, -1 if the name is invalid
+ */
+int set_shared_instance(const char *instance);
+
 /**
  * @brief creates and intializes shared memory and creates the semaphores for shared memory access.
- * @details creates shared memory and sets its size to the size of the shared_data struct. The semaphores are created
- *          with the corresponding start values. Should only be called once.
+ * @details creates shared memory and sets its size to the size of the shared_data struct plus the capacity of the
+ *          buffer. The capacity and the best size are initialized before the semaphores are created with the
+ *          corresponding start values, so generators never see an uninitialized buffer or bound. Should only be
+ *          called once. If the shared memory of the instance already exists but the supervisor that created it
+ *          does not run anymore, the stale shared memory and semaphores are removed first.
+ * @param capacity the capacity of the solution buffer in bytes, between MIN_BUFFER_CAPACITY and MAX_BUFFER_CAPACITY.
+ *                 It is rounded down to a multiple of SHARED_BUFFER_ALIGNMENT.
+ * @param size the size of the shared memory, which has to be mapped, is written to this address
  * @return the file descriptor of the shared memory or -1 if an error occured
  */
-int create_shared_memory(void);
+int create_shared_memory(size_t capacity, size_t *size);
 
 /**
  *	@brief intializes shared memory and opens the semaphores for shared memory access.
  * @details initializes shared memory that has already been created. Opens the semaphores, which also have to be created
  *          before this function is called.
+ * @param size the size of the shared memory, which has to be mapped, is written to this address
  * @return the file descriptor of the shared memory or -1 if an error occured
  */
-int init_shared_memory(void);
+int init_shared_memory(size_t *size);
 
 /**
  * @brief unlinks the shared memory
@@ -65,18 +180,143 @@ int close_semaphores(void);
  * @details writes a solution to the solutions circular buffer. This function may have to wait for data to be read in order
  *          to be able to write new data into the buffer. If the quit flag is true this function does not write to the buffer.
  * @param data the shared data struct that should be accessed
- * @param solution a string representation of a feedback arc set
+ * @param solution the feedback arc set, only the edges that fit into a record are written
+ * @return true if the process calling this method should quit, false otherwise
+ */
+bool write_solution(shared_data_t* data, const solution_t *solution);
+
+/**
+ * @brief writes several solutions to the solutions buffer while holding the write semaphore only once
+ * @details behaves like write_solution for every solution, but other writers can not interleave their solutions
+ *          with the given ones and the write semaphore is only acquired once per batch. Each solution is made
+ *          visible to the reader as soon as it is written.
+ * @param data the shared data struct that should be accessed
+ * @param solutions the feedback arc sets, only the edges that fit into a record are written
+ * @param count the number of solutions
  * @return true if the process calling this method should quit, false otherwise
  */
-bool write_solution(shared_data_t* data, char *solution);
+bool write_solutions(shared_data_t* data, const solution_t *const *solutions, size_t count);
+
+/**
+ * @brief returns the number of edges of the largest solution that fits into the buffer
+ * @param data the shared data struct that should be accessed
+ * @return the number of edges
+ */
+size_t get_max_solution_size(const shared_data_t* data);
+
+/**
+ * @brief allocates a solution that can hold the given number of edges
+ * @param max_edges the number of edges
+ * @return the solution, which has to be freed with free, or NULL if a memory allocation error occured
+ */
+solution_t* create_solution(size_t max_edges);
+
+/**
+ * @brief releases the write semaphore if it is held by the given process
+ * @details must only be called after the process terminated, for example because it crashed while it was writing
+ *          solutions. Records the process had not finished yet are not visible to the reader. A process that
+ *          terminated right after acquiring the semaphore and before it set the writer field is not detected.
+ * @param data the shared data struct that should be accessed
+ * @param pid the process id of the terminated process
+ * @return true if the process held the write semaphore and it was released, false otherwise
+ */
+bool recover_writer(shared_data_t* data, pid_t pid);
+
+/**
+ * @brief returns the size of the best solution the supervisor has received so far
+ * @details the value is read atomically, so generators can check it for every sample without a semaphore.
+ * @param data the shared data struct that should be accessed
+ * @return the best size, solutions that are not smaller than it should not be published
+ */
+int get_best_size(shared_data_t* data);
+
+/**
+ * @brief atomically sets the size of the best solution, which is read by the generators
+ * @param data the shared data struct that should be accessed
+ * @param best_size the size of the best solution
+ */
+void set_best_size(shared_data_t* data, int best_size);
+
+/**
+ * @brief returns whether the generators should publish every solution instead of only better ones
+ * @param data the shared data struct that should be accessed
+ * @return true if every solution should be published, false if only solutions smaller than the best size
+ */
+bool get_publish_all(shared_data_t* data);
+
+/**
+ * @brief atomically sets whether the generators should publish every solution instead of only better ones
+ * @details the supervisor sets it before it starts the generators if it needs every solution, e.g. to measure how
+ *          many of them are duplicates.
+ * @param data the shared data struct that should be accessed
+ * @param publish_all true if every solution should be published
+ */
+void set_publish_all(shared_data_t* data, bool publish_all);
+
+/**
+ * @brief atomically adds the given number of evaluated samples to the counter of all generators
+ * @details generators should add their samples in batches, so they do not contend for the counter on every sample.
+ * @param data the shared data struct that should be accessed
+ * @param count the number of samples that were evaluated since the last call
+ */
+void add_samples(shared_data_t* data, uint64_t count);
+
+/**
+ * @brief returns the number of samples all generators have evaluated so far
+ * @param data the shared data struct that should be accessed
+ * @return the number of samples, including the ones that were not published
+ */
+uint64_t get_samples(shared_data_t* data);
+
+/**
+ * @brief atomically takes the next work item of the exact solver and records it as in progress by this process
+ * @details items of generators that terminated before they finished them are taken first, afterwards every item
+ *          is handed out once, no matter how many generators and threads take items concurrently. An item is only
+ *          handed out twice if its generator terminated between recording and taking it, so the results have to
+ *          be deduplicated by their item.
+ * @param data the shared data struct that should be accessed
+ * @param item_count the number of work items
+ * @param slot the slot the item is recorded in is written to this address, it has to be passed to
+ *             finish_work_item
+ * @return the index of the work item, or item_count if no item is left or all MAX_WORK_SLOTS slots are in use
+ */
+unsigned int take_work_item(shared_data_t* data, unsigned int item_count, size_t *slot);
+
+/**
+ * @brief records that the work item in the given slot is finished
+ * @details must only be called after the result of the item was written, so a generator that terminates before
+ *          that leaves the item to recover_work_items.
+ * @param data the shared data struct that should be accessed
+ * @param slot the slot returned by take_work_item
+ */
+void finish_work_item(shared_data_t* data, size_t slot);
+
+/**
+ * @brief hands the unfinished work items of the given process out again
+ * @details must only be called after the process terminated.
+ * @param data the shared data struct that should be accessed
+ * @param pid the process id of the terminated process
+ * @return the number of items that are handed out again
+ */
+unsigned int recover_work_items(shared_data_t* data, pid_t pid);
+
+/**
+ * @brief takes a snapshot of the state of the solution buffer
+ * @details the values are read atomically but not all at the same time, so they are only approximately consistent.
+ * @param data the shared data struct that should be accessed
+ * @param stats the snapshot is written to this address
+ */
+void get_buffer_stats(shared_data_t* data, buffer_stats_t *stats);
 
 /**
  * @brief reads a solution from the solutions buffer
  * @details reads a solution from the solutions  circular buffer. This function may have to wait for new data to be written in order
  *          to be able read from the buffer.
  * @param data the shared data struct that should be accessed
- * @return a string representation of a feedback arc set or NULL if an error occured
+ * @param solution the solution that the feedback arc set should be copied into, it has to be able to hold
+ *                 get_max_solution_size edges
+ * @return 0 if a solution was read, -1 if an error occured or the waiting was interrupted (errno is set to EINTR)
  */
-char* read_solution(shared_data_t* data);
+int read_solution(shared_data_t* data, solution_t *solution);
 
 #endif
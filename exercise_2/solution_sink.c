@@ -0,0 +1,144 @@
+#include "solution_sink.h"
+#include <string.h>
+
+/**
+ * @brief mixes the bits of the given value with the splitmix64 finalizer
+ * @param x the value
+ * @return the mixed value
+ */
+static uint64_t mix(uint64_t x) {
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return x;
+}
+
+solution_sink_t* create_solution_sink(const char *path) {
+	solution_sink_t *sink = calloc(1, sizeof(solution_sink_t));
+	if(sink == NULL){
+		perror("solution_sink: Memory allocation error occured.");
+		return NULL;
+	}
+	sink->capacity = SINK_INITIAL_CAPACITY;
+	sink->slots = calloc(sink->capacity, sizeof(uint64_t));
+	sink->write_buffer = malloc(SINK_WRITE_BUFFER_SIZE);
+	if(sink->slots == NULL || sink->write_buffer == NULL){
+		perror("solution_sink: Memory allocation error occured.");
+		free(sink->slots);
+		free(sink->write_buffer);
+		free(sink);
+		return NULL;
+	}
+	sink->file = fopen(path, "wb");
+	if(sink->file == NULL){
+		perror("solution_sink: Error opening solution file");
+		free(sink->slots);
+		free(sink->write_buffer);
+		free(sink);
+		return NULL;
+	}
+	setvbuf(sink->file, sink->write_buffer, _IOFBF, SINK_WRITE_BUFFER_SIZE);
+	solution_file_header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SOLUTION_FILE_MAGIC, sizeof(header.magic));
+	header.version = SOLUTION_FILE_VERSION;
+	if(fwrite(&header, sizeof(header), 1, sink->file) != 1){
+		perror("solution_sink: Error writing solution file");
+		close_solution_sink(sink);
+		return NULL;
+	}
+	return sink;
+}
+
+uint64_t hash_solution(const solution_t *solution) {
+	uint64_t sum = 0;
+	uint32_t i;
+	for(i = 0; i < solution->size; i++){
+		sum += mix(((uint64_t)(uint32_t)solution->edges[i].source << 32) |
+				(uint32_t)solution->edges[i].destination);
+	}
+	uint64_t hash = mix(sum ^ mix(solution->size));
+	return hash == 0 ? 1 : hash;
+}
+
+/**
+ * @brief returns the slot that holds the given hash or the empty slot where it has to be inserted
+ * @param slots the slots of the table
+ * @param capacity the number of slots, a power of two
+ * @param hash the hash
+ * @return the slot
+ */
+static uint64_t* find_slot(uint64_t *slots, size_t capacity, uint64_t hash) {
+	size_t i = hash & (capacity - 1);
+	while(slots[i] != 0 && slots[i] != hash){
+		i = (i + 1) & (capacity - 1);
+	}
+	return &slots[i];
+}
+
+/**
+ * @brief doubles the number of slots of the hash table of the given sink
+ * @param sink the sink
+ * @return 0 on success, -1 if a memory allocation error occured
+ */
+static int grow_table(solution_sink_t *sink) {
+	size_t capacity = sink->capacity * 2, i;
+	uint64_t *slots = calloc(capacity, sizeof(uint64_t));
+	if(slots == NULL){
+		perror("solution_sink: Memory allocation error occured.");
+		return -1;
+	}
+	for(i = 0; i < sink->capacity; i++){
+		if(sink->slots[i] != 0){
+			*find_slot(slots, capacity, sink->slots[i]) = sink->slots[i];
+		}
+	}
+	free(sink->slots);
+	sink->slots = slots;
+	sink->capacity = capacity;
+	return 0;
+}
+
+int sink_solution(solution_sink_t *sink, const solution_t *solution) {
+	sink->received++;
+	uint64_t hash = hash_solution(solution);
+	uint64_t *slot = find_slot(sink->slots, sink->capacity, hash);
+	if(*slot == hash){
+		sink->duplicates++;
+		return 1;
+	}
+	//the table is kept at most half full, so probe sequences stay short
+	if((sink->distinct + 1) * 2 > sink->capacity){
+		if(grow_table(sink) == -1){
+			return -1;
+		}
+		slot = find_slot(sink->slots, sink->capacity, hash);
+	}
+	*slot = hash;
+	sink->distinct++;
+	uint32_t size = solution->size;
+	if(fwrite(&size, sizeof(size), 1, sink->file) != 1 ||
+			fwrite(solution->edges, sizeof(edge_t), size, sink->file) != size){
+		perror("solution_sink: Error writing solution file");
+		return -1;
+	}
+	return 0;
+}
+
+double get_duplicate_rate(const solution_sink_t *sink) {
+	return sink->received == 0 ? 0 : (double)sink->duplicates / sink->received;
+}
+
+int close_solution_sink(solution_sink_t *sink) {
+	int result = 0;
+	if(fclose(sink->file) == EOF){
+		perror("solution_sink: Error writing solution file");
+		result = -1;
+	}
+	free(sink->write_buffer);
+	free(sink->slots);
+	free(sink);
+	return result;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file
+ * @brief solution_sink module streams the distinct solutions the supervisor receives into a file
+ *
+ * @autor Benjamin Deutsch (12215881)
+ * @date 16.11.2023
+ */
+#ifndef SOLUTION_SINK_H
+#define SOLUTION_SINK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "shared_buffer.h"
+
+#define SOLUTION_FILE_MAGIC "FASS"
+#define SOLUTION_FILE_VERSION 1
+#define SINK_INITIAL_CAPACITY 4096 //the initial number of slots of the hash table, has to be a power of two
+#define SINK_WRITE_BUFFER_SIZE (1 << 20) //the size of the buffer of the output file in bytes
+
+/**
+ * @brief the header of a solution file
+ * @details the header is followed by the distinct solutions in the order they were received. Every solution is
+ *          stored as its size as uint32_t followed by size edges in the memory layout of edge_t. All numbers are
+ *          stored in the byte order of the machine that wrote the file.
+ */
+typedef struct solution_file_header {
+	char magic[4];
+	uint32_t version;
+} solution_file_header_t;
+
+/**
+ * @brief a sink that writes every solution it has not seen before into a file
+ * @details slots is an open addressing hash table with linear probing that stores the hashes of the edge sets of
+ *          the solutions received so far, 0 marks an empty slot. Only the hashes are stored, so two different
+ *          edge sets with the same hash are counted as duplicates, which is unlikely with 64 bit hashes.
+ */
+typedef struct solution_sink {
+	FILE *file;
+	char *write_buffer;
+	uint64_t *slots;
+	size_t capacity;
+	size_t distinct;
+	unsigned long received;
+	unsigned long duplicates;
+} solution_sink_t;
+
+/**
+ * @brief creates a sink that writes into the given file
+ * @details the file is created or truncated and the header is written.
+ * @param path the path of the file
+ * @return the sink or NULL if the file could not be opened or a memory allocation error occured
+ */
+solution_sink_t* create_solution_sink(const char *path);
+
+/**
+ * @brief returns the hash of the edge set of the given solution
+ * @details every edge is hashed with the splitmix64 finalizer and the hashes are summed up, so the hash does not
+ *          depend on the order of the edges. The sum is mixed again together with the size of the solution.
+ * @param solution the solution
+ * @return the hash, which is never 0
+ */
+uint64_t hash_solution(const solution_t *solution);
+
+/**
+ * @brief passes a solution to the sink
+ * @details the solution is written into the buffered file if its edge set was not received before, otherwise it
+ *          is only counted as a duplicate. Amortized constant time apart from the writing.
+ * @param sink the sink
+ * @param solution the solution
+ * @return 1 if the solution is a duplicate, 0 if it was written, -1 if the file could not be written or a memory
+ *         allocation error occured
+ */
+int sink_solution(solution_sink_t *sink, const solution_t *solution);
+
+/**
+ * @brief returns the share of the received solutions that were duplicates
+ * @param sink the sink
+ * @return the share between 0 and 1, 0 if no solution was received
+ */
+double get_duplicate_rate(const solution_sink_t *sink);
+
+/**
+ * @brief flushes and closes the file of the sink and frees its memory
+ * @param sink the sink
+ * @return 0 on success, -1 if the file could not be written
+ */
+int close_solution_sink(solution_sink_t *sink);
+
+#endif /* SOLUTION_SINK_H */
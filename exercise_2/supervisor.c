@@ -11,17 +11,134 @@
 #include <stdbool.h>
 #include <signal.h>
 #include <string.h>
+#include <errno.h>
+#include <time.h>
 #include <sys/mman.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include "shared_buffer.h"
+#include "generator_pool.h"
+#include "graph_file.h"
+#include "solution_sink.h"
 
-static bool quit = false;
+static volatile sig_atomic_t quit = false;
+static volatile sig_atomic_t ticks = 0;
+static volatile sig_atomic_t children_changed = false;
+
+/**
+ * @brief the results of the work items of the exact solver that have been received so far
+ * @details component_sizes stores the smallest size that was received for every component, or -1 if no result of
+ *          the component was received yet. finished marks the items whose result was received, an item whose
+ *          generator crashed after it wrote the result can be solved and received twice. Once all items are
+ *          finished, the sum of the component sizes is the size of a minimum feedback arc set.
+ */
+typedef struct exact_results {
+	int *component_sizes;
+	bool *finished;
+	unsigned int component_count;
+	unsigned int item_count;
+	unsigned int finished_items;
+} exact_results_t;
+
+/**
+ * @brief the number of solutions and improvements that were received from one generator process
+ */
+typedef struct generator_stats {
+	uint32_t pid;
+	unsigned long solutions;
+	unsigned long improvements;
+} generator_stats_t;
+
+/**
+ * @brief the statistics that are reported periodically if the -s option is given
+ * @details reported_solutions and reported_buffer are the values at the time of the last report, so that the
+ *          rates of the current interval can be computed. generators grows with every new generator process.
+ */
+typedef struct supervisor_stats {
+	struct timespec start;
+	struct timespec last_report;
+	struct timespec last_improvement;
+	unsigned long solutions;
+	unsigned long reported_solutions;
+	buffer_stats_t reported_buffer;
+	generator_stats_t *generators;
+	size_t generator_count;
+	size_t generator_capacity;
+} supervisor_stats_t;
+
+/**
+ * @brief writes the given solution to a checkpoint file
+ * @details the solution is written as a text edge list to a temporary file, which is synced and then renamed to
+ *          the checkpoint file, so the checkpoint file always contains a complete solution, even if the supervisor
+ *          is killed while it writes it.
+ * @param path the path of the checkpoint file
+ * @param best the solution
+ * @return 0 on success, -1 if the file could not be written
+ */
+static int write_checkpoint(const char *path, const solution_t *best) {
+	size_t length = strlen(path);
+	char *temporary = malloc(length + sizeof(".tmp"));
+	if(temporary == NULL){
+		perror("supervisor: Memory allocation error");
+		return -1;
+	}
+	memcpy(temporary, path, length);
+	strcpy(temporary + length, ".tmp");
+	FILE *file = fopen(temporary, "w");
+	if(file == NULL){
+		perror("supervisor: Error opening checkpoint");
+		free(temporary);
+		return -1;
+	}
+	uint32_t i;
+	bool failed = fprintf(file, "# feedback arc set with %u edges\n", best->size) < 0;
+	for(i = 0; i < best->size && !failed; i++){
+		failed = fprintf(file, "%d-%d\n", best->edges[i].source, best->edges[i].destination) < 0;
+	}
+	failed = failed || fflush(file) == EOF || fsync(fileno(file)) == -1;
+	failed = fclose(file) == EOF || failed;
+	if(failed || rename(temporary, path) == -1){
+		perror("supervisor: Error writing checkpoint");
+		unlink(temporary);
+		free(temporary);
+		return -1;
+	}
+	free(temporary);
+	return 0;
+}
+
+/**
+ * @brief reads the solution of a checkpoint file
+ * @param path the path of the checkpoint file
+ * @param best the solution the edges should be copied into
+ * @param max_edges the number of edges the solution can hold
+ * @return 0 on success, -1 if the file could not be read or the solution does not fit
+ */
+static int read_checkpoint(const char *path, solution_t *best, size_t max_edges) {
+	edge_list_t list;
+	if(load_graph_file(path, &list) == -1){
+		return -1;
+	}
+	if(list.edge_count > max_edges){
+		fprintf(stderr, "supervisor: The checkpoint does not fit into the buffer\n");
+		free_edge_list(&list);
+		return -1;
+	}
+	memcpy(best->edges, list.edges, list.edge_count * sizeof(edge_t));
+	best->size = list.edge_count;
+	best->kind = SOLUTION_SAMPLE;
+	best->generator = 0;
+	free_edge_list(&list);
+	return 0;
+}
 
 /**
  * @brief prints the usage message for the supervisor
  */
 static void print_usage_message(void) {
-	printf("USAGE: supervisor [-n limit] [-w delay] [-p]\n");
+	printf("USAGE: supervisor [-i instance] [-n samples] [-w delay] [-b bytes] [-s interval] [-g generators] [-c CHECKPOINT] "
+			"[-r CHECKPOINT] [-o FILE] [-p] "
+			"[-- GENERATOR_ARGUMENT...]\n");
 }
 
 /**
@@ -33,33 +150,222 @@ static void handle_signal(int signal) {
 }
 
 /**
- * @brief returns the size of a feedback arc set solution
- * @details calclates the size of a feedback arc set solution by counting the occurences of the '-' character
- *          and returns the number of occurences.
- * @return the size of the solution
+ * @brief handles the timer signal by counting the ticks of the timer
+ * @details the signal interrupts read_solution, so the statistics are reported and the generators are checked even
+ *          if no solutions arrive. The main loop compares the counter with the ticks it already handled, so a tick
+ *          that arrives while the previous one is handled is not lost.
+ * @param signal the signal
  */
-static int get_solution_size(char *str){
-	int i;
-	int size = 0;
-	for(i = 0; i < strlen(str); i++){
-		if(str[i] == '-'){
-			size++;
+static void handle_timer(int signal) {
+	ticks++;
+}
+
+/**
+ * @brief handles the SIGCHLD signal by setting the children_changed flag to true
+ * @details the signal interrupts read_solution, so crashed generators are restarted right away.
+ * @param signal the signal
+ */
+static void handle_child(int signal) {
+	children_changed = true;
+}
+
+/**
+ * @brief returns the path of the generator executable that lies next to the supervisor executable
+ * @param supervisor_path the path the supervisor was called with
+ * @return the path, which has to be freed by the caller, or NULL if a memory allocation error occured
+ */
+static char* get_generator_path(const char *supervisor_path) {
+	const char *slash = strrchr(supervisor_path, '/');
+	size_t directory_length = slash == NULL ? 0 : slash - supervisor_path + 1;
+	char *path = malloc(directory_length + sizeof("generator"));
+	if(path == NULL){
+		perror("supervisor: Memory allocation error");
+		return NULL;
+	}
+	memcpy(path, supervisor_path, directory_length);
+	strcpy(path + directory_length, "generator");
+	return path;
+}
+
+/**
+ * @brief returns the seconds elapsed between the two given points in time
+ * @param start the earlier point in time
+ * @param end the later point in time
+ * @return the elapsed seconds
+ */
+static double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+	return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief counts a received solution for the generator that found it
+ * @param stats the statistics
+ * @param solution the solution
+ * @param improvement whether the solution is better than all solutions received before
+ * @return 0 if the solution was counted, -1 if a memory allocation error occured
+ */
+static int add_stats_solution(supervisor_stats_t *stats, const solution_t *solution, bool improvement) {
+	size_t i;
+	stats->solutions++;
+	for(i = 0; i < stats->generator_count && stats->generators[i].pid != solution->generator; i++);
+	if(i == stats->generator_count){
+		if(stats->generator_count == stats->generator_capacity){
+			size_t capacity = stats->generator_capacity * 2 + 4;
+			generator_stats_t *generators = realloc(stats->generators, capacity * sizeof(generator_stats_t));
+			if(generators == NULL){
+				perror("supervisor: Memory allocation error");
+				return -1;
+			}
+			stats->generators = generators;
+			stats->generator_capacity = capacity;
 		}
+		stats->generators[i].pid = solution->generator;
+		stats->generators[i].solutions = 0;
+		stats->generators[i].improvements = 0;
+		stats->generator_count++;
+	}
+	stats->generators[i].solutions++;
+	if(improvement){
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		stats->generators[i].improvements++;
+		fprintf(stderr, "supervisor: %.3fs: new best %u from generator %u, %.3fs after the previous best\n",
+				elapsed_seconds(&stats->start, &now), solution->size, solution->generator,
+				elapsed_seconds(&stats->last_improvement, &now));
+		stats->last_improvement = now;
+	}
+	return 0;
+}
+
+/**
+ * @brief prints the statistics of the interval since the last report to stderr
+ * @details reports the consumed solutions per second, the occupancy of the buffer, the share of the interval in
+ *          which the supervisor was blocked because the buffer was empty, the time the generators were blocked
+ *          because it was full, the share of duplicate solutions if a sink is given and the number of solutions
+ *          and improvements of every generator.
+ * @param stats the statistics
+ * @param data the shared data struct that should be accessed
+ * @param best_size the size of the best solution so far, or -1 if there is none
+ * @param sink the sink the solutions are written to, or NULL if there is none
+ */
+static void report_stats(supervisor_stats_t *stats, shared_data_t *data, int best_size, const solution_sink_t *sink) {
+	struct timespec now;
+	buffer_stats_t buffer;
+	size_t i;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	get_buffer_stats(data, &buffer);
+	double interval = elapsed_seconds(&stats->last_report, &now);
+	fprintf(stderr, "supervisor: %.3fs: %.0f solutions/s, %lu total, best %d, buffer %.1f%% full, "
+			"supervisor blocked %.1f%%, generators blocked %.3fs",
+			elapsed_seconds(&stats->start, &now), (stats->solutions - stats->reported_solutions) / interval,
+			stats->solutions, best_size, 100.0 * buffer.used / buffer.capacity,
+			(buffer.used_wait_ns - stats->reported_buffer.used_wait_ns) / 1e7 / interval,
+			(buffer.free_wait_ns - stats->reported_buffer.free_wait_ns) / 1e9);
+	if(sink != NULL){
+		fprintf(stderr, ", %.1f%% duplicates", 100.0 * get_duplicate_rate(sink));
+	}
+	fprintf(stderr, ", solutions/improvements per generator:");
+	for(i = 0; i < stats->generator_count; i++){
+		fprintf(stderr, " %u: %lu/%lu", stats->generators[i].pid, stats->generators[i].solutions,
+				stats->generators[i].improvements);
+	}
+	fprintf(stderr, "\n");
+	stats->last_report = now;
+	stats->reported_solutions = stats->solutions;
+	stats->reported_buffer = buffer;
+}
+
+/**
+ * @brief adds the result of a work item of the exact solver
+ * @param results the results received so far, the component sizes are allocated with the first result
+ * @param solution a solution of the kind SOLUTION_EXACT
+ * @return 0 if the result was added or ignored, -1 if a memory allocation error occured
+ */
+static int add_exact_result(exact_results_t *results, const solution_t *solution) {
+	unsigned int i;
+	if(results->component_sizes == NULL){
+		results->component_sizes = malloc(solution->component_count * sizeof(int) + 1);
+		results->finished = calloc(solution->item_count + 1, sizeof(bool));
+		if(results->component_sizes == NULL || results->finished == NULL){
+			free(results->component_sizes);
+			free(results->finished);
+			results->component_sizes = NULL;
+			results->finished = NULL;
+			perror("supervisor: Memory allocation error");
+			return -1;
+		}
+		for(i = 0; i < solution->component_count; i++){
+			results->component_sizes[i] = -1;
+		}
+		results->component_count = solution->component_count;
+		results->item_count = solution->item_count;
+	}
+	if(solution->component_count != results->component_count || solution->item_count != results->item_count ||
+			solution->component >= results->component_count || solution->item >= results->item_count){
+		fprintf(stderr, "supervisor: Ignoring exact result of a different graph\n");
+		return 0;
+	}
+	int *size = &results->component_sizes[solution->component];
+	if(*size == -1 || solution->size < *size){
+		*size = solution->size;
+	}
+	if(!results->finished[solution->item]){
+		results->finished[solution->item] = true;
+		results->finished_items++;
+	}
+	return 0;
+}
+
+/**
+ * @brief returns the size of a minimum feedback arc set if all work items of the exact solver are finished
+ * @param results the results received so far
+ * @return the size of a minimum feedback arc set or -1 if not all items are finished yet
+ */
+static int get_exact_size(const exact_results_t *results) {
+	unsigned int i;
+	int size = 0;
+	if(results->component_sizes == NULL || results->finished_items < results->item_count){
+		return -1;
+	}
+	for(i = 0; i < results->component_count; i++){
+		size += results->component_sizes[i];
 	}
 	return size;
 }
 
 /**
  * @brief reads the feedback arc sets generated by the generators from shared memory and remembers the best solution
- * @details initializes the shared memory. Then this function reads the feedback arc sets from the shared memory until
- *         a solution with no edges was encountered, the maximum amount of solutions (specified by the -n parameter)
- *         or the SIGINT or SIGTERM signals are received. After that, the shared memory is released and the generators
- *         are notified to quit.
+ * @details initializes the shared memory. Then this function reads the feedback arc sets from the shared memory
+ *          until a solution with no edges was encountered, all work items of the exact solver were finished, the
+ *          generators evaluated the number of samples specified by the -n parameter or the SIGINT or SIGTERM signals
+ *          are received. After that, the shared memory is released and the generators are notified to quit. If the
+ *          -g parameter is given, the supervisor starts the generators itself, restarts the ones that crash, stops
+ *          reading once all of them terminated and the buffer is empty, and waits for them to quit before it
+ *          releases the shared memory. If they terminated before all work items of the exact solver were finished,
+ *          the supervisor fails.
  * @param argc the number of arguments
  * @param argv can contain the following arguments:
- *             -n [int]: the number of solutions that should be checked
+ *             -i [str]: the name of the instance, so that several supervisors can run at the same time. Generators
+ *                       have to be given the same instance name, generators started with -g get it automatically
+ *             -n [int]: the number of samples the generators should evaluate, including the ones that are not
+ *                       published because they are not better than the best solution. The count is checked
+ *                       whenever a solution arrives and at least once a second
  *             -w [int]: the number of seconds the supervisor should wait after initializing the shared memory and before
  *                       reading the first solution from the shared memory
+ *             -b [int]: the capacity of the solution buffer in the shared memory in bytes, which limits the size
+ *                       of the solutions that can be published. DEFAULT_BUFFER_CAPACITY by default
+ *             -s [int]: print statistics about the throughput of the buffer and the generators to stderr every
+ *                       given number of seconds, and every improvement of the best solution as it happens
+ *             -g [int]: start the given number of generators, each pinned to its own cpu. The generator executable
+ *                       is expected next to the supervisor executable and is called with the arguments after --
+ *             -c [str]: write the best solution to the given checkpoint file once a second if it changed, and
+ *                       when the supervisor terminates. With -r, the resumed solution is written right away
+ *             -r [str]: resume from the given checkpoint file: its solution is the initial best solution, so
+ *                       generators only publish better ones. Generators started with -g are seeded with it, too,
+ *                       so it cannot be combined with generators that are given -e
+ *             -o [str]: write every distinct solution of the generators to the given file and report the share
+ *                       of duplicates, see solution_sink.h for the format. The generators then publish every
+ *                       solution instead of only the ones that are better than the best solution
  *             -p:       specifies that the graphs should be drawn to the console
  * @return EXIT_SUCCESS if the programm executed successfully, EXIT_FAILURE otherwise
  */
@@ -72,9 +378,18 @@ int main(int argc, char *argv[]) {
 	sigaction(SIGTERM, &sa, NULL);
 	
 	//read input
-	int c, n = -1, w = 0, count;
-	while((c = getopt(argc, argv, "n:w:p")) != -1){
+	int c, n = -1, w = 0, interval = 0, generator_count = 0, count;
+	long capacity = DEFAULT_BUFFER_CAPACITY;
+	char *instance = NULL, *checkpoint = NULL, *resume = NULL, *output = NULL;
+	while((c = getopt(argc, argv, "+i:n:w:b:s:g:c:r:o:p")) != -1){
 		switch(c) {
+			case 'i':
+				if(set_shared_instance(optarg) == -1){
+					print_usage_message();
+					return EXIT_FAILURE;
+				}
+				instance = optarg;
+				break;
 			case 'n':
 				count = sscanf(optarg, "%d", &n);
 				if(count != 1 || n < 0){
@@ -89,6 +404,36 @@ int main(int argc, char *argv[]) {
 					return EXIT_FAILURE;
 				}
 				break;
+			case 'b':
+				count = sscanf(optarg, "%ld", &capacity);
+				if(count != 1 || capacity < MIN_BUFFER_CAPACITY || capacity > MAX_BUFFER_CAPACITY){
+					print_usage_message();
+					return EXIT_FAILURE;
+				}
+				break;
+			case 's':
+				count = sscanf(optarg, "%d", &interval);
+				if(count != 1 || interval < 1){
+					print_usage_message();
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'g':
+				count = sscanf(optarg, "%d", &generator_count);
+				if(count != 1 || generator_count < 1){
+					print_usage_message();
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'c':
+				checkpoint = optarg;
+				break;
+			case 'r':
+				resume = optarg;
+				break;
+			case 'o':
+				output = optarg;
+				break;
 			case 'p':
 				break;
 			default:
@@ -97,13 +442,18 @@ int main(int argc, char *argv[]) {
 				
 		}
 	}
+	if(generator_count == 0 && optind < argc){
+		print_usage_message();
+		return EXIT_FAILURE;
+	}
 	bool checkN = (n != -1);
 	
-	int shmfd = create_shared_memory();
+	size_t shared_size;
+	int shmfd = create_shared_memory(capacity, &shared_size);
 	if(shmfd == -1){
 		return EXIT_FAILURE;
 	}
-	shared_data_t *shared_data = mmap(NULL, sizeof(shared_data_t), PROT_READ | PROT_WRITE, MAP_SHARED, shmfd, 0);
+	shared_data_t *shared_data = mmap(NULL, shared_size, PROT_READ | PROT_WRITE, MAP_SHARED, shmfd, 0);
 	if(shared_data == MAP_FAILED){
 		close(shmfd);
 		perror("supervisor: Shared memory mapping failed");
@@ -114,37 +464,193 @@ int main(int argc, char *argv[]) {
 		return EXIT_FAILURE;
 	}
 	
+	//the bound of a resumed search is set before any generator can start
+	int best_size = -1, exact_size = -1;
+	bool acyclic = false, checkpoint_changed = false;
+	solution_t *solution = create_solution(get_max_solution_size(shared_data));
+	solution_t *best = create_solution(get_max_solution_size(shared_data));
+	solution_sink_t *sink = NULL;
+	bool error = solution == NULL || best == NULL;
+	if(!error && output != NULL) {
+		//the share of duplicates is only meaningful if the generators publish every solution, not only better ones
+		sink = create_solution_sink(output);
+		error = sink == NULL;
+		set_publish_all(shared_data, true);
+	}
+	if(!error && resume != NULL) {
+		error = read_checkpoint(resume, best, get_max_solution_size(shared_data)) == -1;
+		if(!error) {
+			best_size = best->size;
+			set_best_size(shared_data, best_size);
+			//the checkpoint holds the resumed solution even if the run does not find a better one
+			error = checkpoint != NULL && write_checkpoint(checkpoint, best) == -1;
+			if(best_size == 0) {
+				printf("The graph is acyclic!\n");
+				acyclic = true;
+			}
+		}
+	}
+	
+	//start the generators, the shared memory and the semaphores exist at this point
+	generator_pool_t *pool = NULL;
+	char *generator_path = NULL;
+	char **generator_args = NULL;
+	if(generator_count > 0 && !error){
+		struct sigaction child_action;
+		memset(&child_action, 0, sizeof(child_action));
+		child_action.sa_handler = handle_child;
+		child_action.sa_flags = SA_NOCLDSTOP;
+		sigaction(SIGCHLD, &child_action, NULL);
+		generator_path = get_generator_path(argv[0]);
+		generator_args = malloc((argc - optind + 4) * sizeof(char*));
+		if(generator_path != NULL && generator_args != NULL){
+			//the generators write to the instance of the supervisor and start from its checkpoint
+			size_t arg_count = 0;
+			if(instance != NULL){
+				generator_args[arg_count++] = "-i";
+				generator_args[arg_count++] = instance;
+			}
+			if(resume != NULL){
+				generator_args[arg_count++] = "-r";
+				generator_args[arg_count++] = resume;
+			}
+			memcpy(generator_args + arg_count, argv + optind, (argc - optind) * sizeof(char*));
+			arg_count += argc - optind;
+			pool = create_generator_pool(generator_count, generator_path, generator_args, arg_count);
+		}else if(generator_args == NULL){
+			perror("supervisor: Memory allocation error");
+		}
+		error = pool == NULL || start_generators(pool) == -1;
+	}
+	
 	sleep(w);
 	
-	int best_size = -1;
-	bool acyclic = false;
-	int asdf = 0;
-	while(!quit && !acyclic && (!checkN || n > 0)) {
-		asdf++;
-		char *str = read_solution(shared_data);
-		int solution_size = get_solution_size(str);
+	supervisor_stats_t stats;
+	memset(&stats, 0, sizeof(stats));
+	clock_gettime(CLOCK_MONOTONIC, &stats.start);
+	stats.last_report = stats.start;
+	stats.last_improvement = stats.start;
+	get_buffer_stats(shared_data, &stats.reported_buffer);
+	if(interval > 0 || pool != NULL || checkpoint != NULL || checkN){
+		struct sigaction timer_action;
+		memset(&timer_action, 0, sizeof(timer_action));
+		timer_action.sa_handler = handle_timer;
+		sigaction(SIGALRM, &timer_action, NULL);
+		//the generators, the checkpoint and the sample count are checked every second, in case a SIGCHLD arrived
+		//right before read_solution blocked or no solution arrives, the statistics are reported every interval-th tick
+		struct itimerval timer;
+		timer.it_interval.tv_sec = 1;
+		timer.it_interval.tv_usec = 0;
+		timer.it_value = timer.it_interval;
+		setitimer(ITIMER_REAL, &timer, NULL);
+	}
+	
+	exact_results_t exact_results;
+	memset(&exact_results, 0, sizeof(exact_results));
+	int handled_ticks = 0;
+	while(!error && !quit && !acyclic && exact_size == -1 && (!checkN || get_samples(shared_data) < (uint64_t)n)) {
+		int current_ticks = ticks;
+		bool timer_expired = current_ticks != handled_ticks;
+		if(timer_expired && interval > 0 && current_ticks / interval != handled_ticks / interval) {
+			report_stats(&stats, shared_data, best_size, sink);
+		}
+		handled_ticks = current_ticks;
+		if(timer_expired && checkpoint_changed) {
+			checkpoint_changed = write_checkpoint(checkpoint, best) == -1;
+		}
+		if(pool != NULL && (children_changed || timer_expired)) {
+			children_changed = false;
+			if(restart_crashed_generators(pool, shared_data) == -1) {
+				error = true;
+				break;
+			}
+			buffer_stats_t buffer;
+			get_buffer_stats(shared_data, &buffer);
+			if(pool->running == 0 && buffer.used == 0) {
+				fprintf(stderr, "supervisor: All generators terminated\n");
+				error = pool->failed == pool->count;
+				if(exact_results.component_sizes != NULL) {
+					fprintf(stderr, "supervisor: Only %u of %u exact work items were finished\n",
+							exact_results.finished_items, exact_results.item_count);
+					error = true;
+				}
+				break;
+			}
+		}
+		if(read_solution(shared_data, solution) == -1) {
+			if(errno != EINTR) {
+				error = true;
+				break;
+			}
+			continue;
+		}
+		if(interval > 0 && add_stats_solution(&stats, solution, solution->kind == SOLUTION_SAMPLE &&
+				(best_size == -1 || (int)solution->size < best_size)) == -1) {
+			error = true;
+			break;
+		}
+		if(solution->kind == SOLUTION_EXACT) {
+			if(add_exact_result(&exact_results, solution) == -1) {
+				error = true;
+				break;
+			}
+			exact_size = get_exact_size(&exact_results);
+			continue;
+		}
+		if(sink != NULL && sink_solution(sink, solution) == -1) {
+			error = true;
+			break;
+		}
+		int solution_size = solution->size;
 		if(solution_size == 0) {
 			printf("The graph is acyclic!\n");
 			acyclic = true;
 		}
 		if(best_size == -1 || solution_size < best_size) {
 			best_size = solution_size;
-			//printf("Solution with %d edges: %s\n", best_size, str);
-		}
-		free(str);
-		if(checkN){
-			n--;
+			set_best_size(shared_data, best_size);
+			memcpy(best, solution, sizeof(solution_t) + solution->size * sizeof(edge_t));
+			checkpoint_changed = checkpoint != NULL;
 		}
 	}
 	shared_data->quit = true;
-	if(!acyclic) {
+	if(checkpoint_changed && write_checkpoint(checkpoint, best) == -1) {
+		error = true;
+	}
+	if(interval > 0) {
+		report_stats(&stats, shared_data, best_size, sink);
+	}
+	if(sink != NULL) {
+		fprintf(stderr, "supervisor: %lu of %lu solutions were duplicates (%.1f%%), %lu distinct solutions written\n",
+				sink->duplicates, sink->received, 100.0 * get_duplicate_rate(sink), (unsigned long)sink->distinct);
+		if(close_solution_sink(sink) == -1) {
+			error = true;
+		}
+	}
+	free(stats.generators);
+	free(solution);
+	free(best);
+	free(exact_results.component_sizes);
+	free(exact_results.finished);
+	if(exact_size != -1) {
+		printf("The graph is not acyclic, a minimum feedback arc set removes %d edges.\n", exact_size);
+	}else if(!acyclic && best_size != -1) {
 		printf("The graph might not be acyclic, best solution removes %d edges.\n", best_size);
 	}
 	
 	if(release_waiting_processes() == -1) {
-		return EXIT_FAILURE;
+		error = true;
+	}
+	if(pool != NULL) {
+		stop_generators(pool);
+		if(pool->restarts > 0) {
+			fprintf(stderr, "supervisor: Restarted %lu crashed generators\n", pool->restarts);
+		}
+		free_generator_pool(pool);
 	}
-	if (munmap(shared_data, sizeof(shared_data_t)) == -1){
+	free(generator_path);
+	free(generator_args);
+	if (munmap(shared_data, shared_size) == -1){
 		perror("supervisor: Shared memory unmapping failed");
 		return EXIT_FAILURE;
 	}
@@ -157,6 +663,6 @@ int main(int argc, char *argv[]) {
 	if(close_semaphores() == -1){
 		return EXIT_FAILURE;
 	}
-	return EXIT_SUCCESS;
+	return error ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
@@ -0,0 +1,126 @@
+#include "vertex_map.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief returns the slot in which the search for the given vertex starts
+ * @param capacity the size of the table, has to be a power of two
+ * @param vertex the id of the vertex
+ * @return the start slot
+ */
+static size_t hash_slot(size_t capacity, int32_t vertex) {
+	uint32_t x = (uint32_t)vertex;
+	x ^= x >> 16;
+	x *= 0x7feb352dU;
+	x ^= x >> 15;
+	x *= 0x846ca68bU;
+	x ^= x >> 16;
+	return x & (capacity - 1);
+}
+
+/**
+ * @brief allocates the tables of the given map with the given capacity
+ * @param map the map whose tables should be allocated
+ * @param capacity the new capacity, has to be a power of two
+ * @return 0 on success, -1 if a memory allocation error occured
+ */
+static int allocate_tables(vertex_map_t *map, size_t capacity) {
+	map->keys = malloc(capacity * sizeof(int32_t));
+	map->indices = calloc(capacity, sizeof(uint32_t));
+	if(map->keys == NULL || map->indices == NULL){
+		free(map->keys);
+		free(map->indices);
+		perror("vertex_map: Memory allocation error occured.");
+		return -1;
+	}
+	map->capacity = capacity;
+	return 0;
+}
+
+/**
+ * @brief doubles the capacity of the given map and reinserts all vertices
+ * @param map the map to grow
+ * @return 0 on success, -1 if a memory allocation error occured
+ */
+static int grow(vertex_map_t *map) {
+	int32_t *old_keys = map->keys;
+	uint32_t *old_indices = map->indices;
+	size_t i, old_capacity = map->capacity;
+	if(allocate_tables(map, old_capacity * 2) == -1){
+		map->keys = old_keys;
+		map->indices = old_indices;
+		return -1;
+	}
+	for(i = 0; i < old_capacity; i++){
+		if(old_indices[i] != 0){
+			size_t slot = hash_slot(map->capacity, old_keys[i]);
+			while(map->indices[slot] != 0){
+				slot = (slot + 1) & (map->capacity - 1);
+			}
+			map->keys[slot] = old_keys[i];
+			map->indices[slot] = old_indices[i];
+		}
+	}
+	free(old_keys);
+	free(old_indices);
+	return 0;
+}
+
+vertex_map_t* create_vertex_map(size_t expected_vertices) {
+	vertex_map_t *map = malloc(sizeof(vertex_map_t));
+	if(map == NULL){
+		perror("vertex_map: Memory allocation error occured.");
+		return NULL;
+	}
+	//keep the load factor below 1/2
+	size_t capacity = 16;
+	while(capacity < expected_vertices * 2){
+		capacity = capacity * 2;
+	}
+	map->length = 0;
+	if(allocate_tables(map, capacity) == -1){
+		free(map);
+		return NULL;
+	}
+	return map;
+}
+
+long vertex_map_get(const vertex_map_t *map, int32_t vertex) {
+	size_t slot = hash_slot(map->capacity, vertex);
+	while(map->indices[slot] != 0){
+		if(map->keys[slot] == vertex){
+			return (long)map->indices[slot] - 1;
+		}
+		slot = (slot + 1) & (map->capacity - 1);
+	}
+	return -1;
+}
+
+long vertex_map_insert(vertex_map_t *map, int32_t vertex) {
+	size_t slot = hash_slot(map->capacity, vertex);
+	while(map->indices[slot] != 0){
+		if(map->keys[slot] == vertex){
+			return (long)map->indices[slot] - 1;
+		}
+		slot = (slot + 1) & (map->capacity - 1);
+	}
+	if((map->length + 1) * 2 > map->capacity){
+		if(grow(map) == -1){
+			return -1;
+		}
+		slot = hash_slot(map->capacity, vertex);
+		while(map->indices[slot] != 0){
+			slot = (slot + 1) & (map->capacity - 1);
+		}
+	}
+	map->keys[slot] = vertex;
+	map->length = map->length + 1;
+	map->indices[slot] = map->length;
+	return (long)map->length - 1;
+}
+
+void free_vertex_map(vertex_map_t *map) {
+	free(map->keys);
+	free(map->indices);
+	free(map);
+}
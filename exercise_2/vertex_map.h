@@ -0,0 +1,57 @@
+/**
+ * @file
+ * @brief vertex_map module provides a hash map that maps arbitrary vertex ids to dense indices 0..n-1
+ *
+ * @autor Benjamin Deutsch (12215881)
+ * @date 16.11.2023
+ */
+#ifndef VERTEX_MAP_H
+#define VERTEX_MAP_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/**
+ * @brief open addressing hash map from vertex ids to dense vertex indices
+ * @details the map uses linear probing in a table whose size is a power of two. The indices array stores the
+ *          dense index of the vertex plus one, so that 0 marks an empty slot. The length property is the number
+ *          of vertices in the map, which is also the next dense index that is handed out.
+ */
+typedef struct vertex_map {
+	int32_t *keys;
+	uint32_t *indices;
+	size_t capacity;
+	size_t length;
+} vertex_map_t;
+
+/**
+ * @brief creates an empty map that can store at least the given number of vertices without growing
+ * @param expected_vertices the number of vertices that are expected to be inserted
+ * @return NULL if a memory allocation error occured, the map otherwise
+ */
+vertex_map_t* create_vertex_map(size_t expected_vertices);
+
+/**
+ * @brief returns the dense index of the vertex with the given id
+ * @param map the map that the vertex should be searched in
+ * @param vertex the id of the vertex
+ * @return the dense index of the vertex or -1 if the map does not contain the vertex
+ */
+long vertex_map_get(const vertex_map_t *map, int32_t vertex);
+
+/**
+ * @brief returns the dense index of the vertex with the given id and inserts the vertex if it is not contained yet
+ * @details newly inserted vertices get the index map->length. Increases the size of the table if necessary.
+ * @param map the map that the vertex should be inserted into
+ * @param vertex the id of the vertex
+ * @return the dense index of the vertex or -1 if a memory allocation error occured
+ */
+long vertex_map_insert(vertex_map_t *map, int32_t vertex);
+
+/**
+ * @brief frees all of the dynamically allocated memory of the given map, including the map itself
+ * @param map the map to be freed
+ */
+void free_vertex_map(vertex_map_t *map);
+
+#endif /* VERTEX_MAP_H */
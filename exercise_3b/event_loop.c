@@ -0,0 +1,903 @@
+#define _GNU_SOURCE
+#include "event_loop.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <limits.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+/**
+ * @brief the state of one event loop
+ * @details oldest and newest are the ends of the list of all open connections, ordered by the time of their last
+ *          progress, so the connections that timed out are always at its start.
+ */
+typedef struct event_loop {
+	int epoll_fd;
+	int listen_fd;
+	const server_config_t *config;
+	connection_t *oldest;
+	connection_t *newest;
+} event_loop_t;
+
+/**
+ * @brief prints an error message to stderr
+ * @param programm_name the name of the programm (argv[0])
+ * @param msg the error message
+ */
+static void error_message(char *programm_name, char *msg) {
+	fprintf(stderr,"%s: %s\n", programm_name, msg);
+}
+
+/**
+ * @brief returns the current monotonic time in milliseconds
+ * @return the time
+ */
+static long long now_ms(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief returns whether the Connection header of the given request contains the close option
+ * @param connection the connection whose request was parsed
+ * @return true if the client asked to close the connection, false otherwise
+ */
+static bool wants_close(const connection_t *connection) {
+	return get_option_quality(&connection->parsed, connection->request, "Connection", "close") >= 0;
+}
+
+/**
+ * @brief returns whether the Accept-Encoding header of the given request accepts the given content coding
+ * @details a coding that is not listed is accepted if the wildcard * is, a quality of 0 rejects it.
+ * @param connection the connection whose request was parsed
+ * @param coding the content coding, e.g. gzip
+ * @return true if the client accepts the coding, false otherwise
+ */
+static bool accepts_encoding(const connection_t *connection, const char *coding) {
+	const http_request_t *request = &connection->parsed;
+	double quality = get_option_quality(request, connection->request, "Accept-Encoding", coding);
+	if(quality < 0) {
+		quality = get_option_quality(request, connection->request, "Accept-Encoding", "*");
+	}
+	return quality > 0;
+}
+
+/**
+ * @brief formats the given point in time as a http date
+ * @param date the buffer the date is written to, it has to hold at least HTTP_DATE_SIZE bytes
+ * @param time the point in time
+ */
+static void format_http_date(char *date, time_t time) {
+	struct tm utc;
+	gmtime_r(&time, &utc);
+	strftime(date, HTTP_DATE_SIZE, "%a, %d %b %Y %H:%M:%S GMT", &utc);
+}
+
+/**
+ * @brief prepares the header of a http response for the given connection
+ * @details the header is written into the header buffer of the connection and is followed by the content of the
+ *          connection, if it has one. The Connection: close header is sent if the connection is closed after the
+ *          response.
+ * @param connection the connection
+ * @param status the response status
+ * @param status_message the response status message
+ * @param headers the headers that describe the content of the response, at least its Content-Length unless the
+ *                status never has content like 304
+ * @return true if the header has been created successfully, false otherwise
+ */
+static bool prepare_response(connection_t *connection, char *status, char *status_message, const char *headers) {
+	char date_str[HTTP_DATE_SIZE];
+	format_http_date(date_str, time(NULL));
+	int length = snprintf(connection->header, sizeof(connection->header),
+			"HTTP/1.1 %s %s\r\nDate: %s\r\n%s%s\r\n", status, status_message, date_str, headers,
+			connection->close_after_response ? "Connection: close\r\n" : "");
+	if(length < 0 || (size_t)length >= sizeof(connection->header)) {
+		return false;
+	}
+	connection->header_length = length;
+	connection->header_sent = 0;
+	return true;
+}
+
+/**
+ * @brief parses the http date in the given header value
+ * @param connection the connection whose request was parsed
+ * @param value the header value
+ * @param time the parsed point in time
+ * @return true on success, false if the value is not a http date
+ */
+static bool parse_http_date(const connection_t *connection, http_slice_t value, time_t *time) {
+	char date[HTTP_DATE_SIZE];
+	if(value.length >= sizeof(date)) {
+		return false;
+	}
+	memcpy(date, connection->request + value.offset, value.length);
+	date[value.length] = '\0';
+	struct tm utc;
+	memset(&utc, 0, sizeof(utc));
+	const char *end = strptime(date, "%a, %d %b %Y %H:%M:%S GMT", &utc);
+	if(end == NULL || *end != '\0') {
+		return false;
+	}
+	*time = timegm(&utc);
+	return true;
+}
+
+/**
+ * @brief returns whether an If-None-Match header of the request lists the given entity tag
+ * @details tags are compared weakly, so a weak tag W/"x" matches the tag "x". The wildcard * matches any tag.
+ * @param connection the connection whose request was parsed
+ * @param etag the entity tag of the file
+ * @return true if a tag matches, false otherwise
+ */
+static bool matches_none_match(const connection_t *connection, const char *etag) {
+	const http_request_t *request = &connection->parsed;
+	size_t etag_length = strlen(etag);
+	const http_header_t *header = find_header(request, connection->request, "If-None-Match", NULL);
+	for(; header != NULL; header = find_header(request, connection->request, "If-None-Match", header)) {
+		const char *current = connection->request + header->value.offset;
+		const char *end = current + header->value.length;
+		while(current < end) {
+			while(current < end && (*current == ' ' || *current == '\t' || *current == ',')) {
+				current++;
+			}
+			const char *tag = current;
+			while(current < end && *current != ' ' && *current != '\t' && *current != ',') {
+				current++;
+			}
+			if(current - tag >= 2 && tag[0] == 'W' && tag[1] == '/') {
+				tag += 2;
+			}
+			if((current - tag == 1 && *tag == '*') ||
+					((size_t)(current - tag) == etag_length && memcmp(tag, etag, etag_length) == 0)) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief returns whether the client has the current version of a file already
+ * @details If-Modified-Since is only evaluated if the request has no If-None-Match header.
+ * @param connection the connection whose request was parsed
+ * @param etag the entity tag of the file
+ * @param last_modified the modification time of the file
+ * @return true if the file is answered with 304, false otherwise
+ */
+static bool is_not_modified(const connection_t *connection, const char *etag, time_t last_modified) {
+	const http_request_t *request = &connection->parsed;
+	if(find_header(request, connection->request, "If-None-Match", NULL) != NULL) {
+		return matches_none_match(connection, etag);
+	}
+	const http_header_t *header = find_header(request, connection->request, "If-Modified-Since", NULL);
+	time_t since;
+	return header != NULL && parse_http_date(connection, header->value, &since) && last_modified <= since;
+}
+
+/**
+ * @brief parses the decimal number at the given position
+ * @param current the position, it is moved behind the number
+ * @param end the end of the value that contains the number
+ * @param number the parsed number
+ * @return true on success, false if there is no number or it overflows
+ */
+static bool parse_number(const char **current, const char *end, unsigned long long *number) {
+	const char *start = *current;
+	*number = 0;
+	for(; *current < end && **current >= '0' && **current <= '9'; (*current)++) {
+		if(*number > (ULLONG_MAX - (**current - '0')) / 10) {
+			return false;
+		}
+		*number = *number * 10 + (**current - '0');
+	}
+	return *current != start;
+}
+
+/**
+ * @brief returns the range of a file that the Range header of the request selects
+ * @details only a single byte range is supported, a request for several ranges is answered with the whole file
+ *          like a request with a Range header that cannot be parsed. The Range header is ignored if the request has
+ *          an If-Range header that does not match the current version of the file.
+ * @param connection the connection whose request was parsed
+ * @param size the size of the file
+ * @param etag the entity tag of the file
+ * @param last_modified the modification time of the file
+ * @param start the first byte of the range
+ * @param end the byte after the range
+ * @return 1 if a range was selected, 0 if the whole file is sent and -1 if the range cannot be satisfied
+ */
+static int get_range(const connection_t *connection, off_t size, const char *etag, time_t last_modified,
+		off_t *start, off_t *end) {
+	const http_request_t *request = &connection->parsed;
+	const http_header_t *header = find_header(request, connection->request, "Range", NULL);
+	if(header == NULL || find_header(request, connection->request, "Range", header) != NULL) {
+		return 0;
+	}
+	const http_header_t *if_range = find_header(request, connection->request, "If-Range", NULL);
+	if(if_range != NULL) {
+		time_t date;
+		bool current = slice_equals(connection->request, if_range->value, etag) ||
+				(parse_http_date(connection, if_range->value, &date) && date == last_modified);
+		if(!current) {
+			return 0;
+		}
+	}
+	const char *value = connection->request + header->value.offset;
+	const char *value_end = value + header->value.length;
+	if(value_end - value < 6 || strncasecmp(value, "bytes=", 6) != 0) {
+		return 0;
+	}
+	value += 6;
+	unsigned long long first, last;
+	if(*value == '-') {
+		//a suffix range selects the last bytes of the file
+		value++;
+		if(!parse_number(&value, value_end, &last) || value != value_end) {
+			return 0;
+		}
+		if(last == 0 || size == 0) {
+			return -1;
+		}
+		*start = last < (unsigned long long)size ? size - (off_t)last : 0;
+		*end = size;
+		return 1;
+	}
+	if(!parse_number(&value, value_end, &first) || value == value_end || *value++ != '-') {
+		return 0;
+	}
+	bool has_last = parse_number(&value, value_end, &last);
+	if(value != value_end || (has_last && last < first)) {
+		return 0;
+	}
+	if(first >= (unsigned long long)size) {
+		return -1;
+	}
+	*start = first;
+	*end = has_last && last < (unsigned long long)size - 1 ? (off_t)last + 1 : size;
+	return 1;
+}
+
+/**
+ * @brief prepares the response with the content of a file
+ * @details the file is answered with 304 if the client has its current version already and with 206 and a part of
+ *          the file if the request selects a range. The response varies with the Accept-Encoding header of the
+ *          request, so caches have to store the representations of the different encodings separately. The
+ *          content is the cached entry of the connection or its file_fd.
+ * @param connection the connection
+ * @param headers the headers that describe the content, see format_file_headers
+ * @param etag the entity tag of the content
+ * @param last_modified the modification time of the content
+ * @param size the size of the content
+ * @param encoding the Content-Encoding of the content, or NULL if it is not encoded
+ * @return true if the header has been created successfully, false otherwise
+ */
+static bool prepare_file_response(connection_t *connection, const char *headers, const char *etag,
+		time_t last_modified, off_t size, const char *encoding) {
+	char *status = "200";
+	char *status_message = "OK";
+	off_t start = 0, end = size;
+	char content_headers[128];
+	content_headers[0] = '\0';
+	if(is_not_modified(connection, etag, last_modified)) {
+		status = "304";
+		status_message = "(Not Modified)";
+		end = 0;
+	}else{
+		int range = get_range(connection, size, etag, last_modified, &start, &end);
+		if(range > 0) {
+			status = "206";
+			status_message = "(Partial Content)";
+			snprintf(content_headers, sizeof(content_headers),
+					"Content-Length: %lld\r\nContent-Range: bytes %lld-%lld/%lld\r\n", (long long)(end - start),
+					(long long)start, (long long)end - 1, (long long)size);
+		}else if(range < 0) {
+			status = "416";
+			status_message = "(Range Not Satisfiable)";
+			start = end = 0;
+			snprintf(content_headers, sizeof(content_headers), "%sContent-Range: bytes */%lld\r\n",
+					EMPTY_CONTENT_HEADERS, (long long)size);
+		}else{
+			snprintf(content_headers, sizeof(content_headers), "Content-Length: %lld\r\n", (long long)size);
+		}
+	}
+	if(connection->cached != NULL) {
+		connection->body_offset = start;
+		connection->body_end = end;
+	}else{
+		connection->file_offset = start;
+		connection->file_end = end;
+	}
+	char file_headers[RESPONSE_HEADER_SIZE];
+	int length = snprintf(file_headers, sizeof(file_headers), "%s%s%s%s%sVary: Accept-Encoding\r\n",
+			content_headers, headers, encoding != NULL ? "Content-Encoding: " : "", encoding != NULL ? encoding : "",
+			encoding != NULL ? "\r\n" : "");
+	if(length < 0 || (size_t)length >= sizeof(file_headers)) {
+		return false;
+	}
+	return prepare_response(connection, status, status_message, file_headers);
+}
+
+/**
+ * @brief prepares the response with the cached content of a file
+ * @param connection the connection
+ * @param entry the entry, the connection takes over its reference
+ * @param encoding the Content-Encoding of the content, or NULL if it is not encoded
+ * @return true if the header has been created successfully, false otherwise
+ */
+static bool serve_cached_file(connection_t *connection, cache_entry_t *entry, const char *encoding) {
+	connection->cached = entry;
+	return prepare_file_response(connection, entry->headers, entry->etag, entry->mtime.tv_sec, entry->size,
+			encoding);
+}
+
+/**
+ * @brief prepares the response with the file at the given path
+ * @details files that are not cached and files the cache cannot hold are sent from the file system.
+ * @param connection the connection
+ * @param config the settings of the server
+ * @param path the path of the file
+ * @param encoding the Content-Encoding of the file, or NULL if it is not encoded
+ * @return 1 if the response has been created, 0 if there is no regular file at the path and -1 if the header could
+ *         not be created
+ */
+static int serve_file(connection_t *connection, const server_config_t *config, const char *path,
+		const char *encoding) {
+	if(config->cache != NULL) {
+		cache_entry_t *entry = acquire_cached_file(config->cache, path, CACHE_PLAIN);
+		if(entry != NULL && !entry->exists) {
+			release_cached_file(entry);
+			return 0;
+		}
+		if(entry != NULL) {
+			return serve_cached_file(connection, entry, encoding) ? 1 : -1;
+		}
+	}
+	int file_fd = open(path, O_RDONLY | O_CLOEXEC);
+	if(file_fd < 0) {
+		return 0;
+	}
+	struct stat file_stat;
+	char headers[FILE_HEADERS_SIZE];
+	if(fstat(file_fd, &file_stat) < 0 || !S_ISREG(file_stat.st_mode) ||
+			format_file_headers(headers, sizeof(headers), &file_stat) < 0) {
+		close(file_fd);
+		return 0;
+	}
+	char etag[ETAG_SIZE];
+	format_etag(etag, &file_stat);
+	connection->file_fd = file_fd;
+	return prepare_file_response(connection, headers, etag, file_stat.st_mtim.tv_sec, file_stat.st_size,
+			encoding) ? 1 : -1;
+}
+
+/**
+ * @brief writes the given path to the given buffer without empty and . segments, resolving every .. segment by
+ *        removing the segment before it
+ * @details every segment of the result is preceded by a /, so the result is empty for the document root and at
+ *          most one byte longer than the path. Two paths that name the same file below the document root therefore
+ *          have the same result, and a result never names a file outside of it.
+ * @param normalized the buffer, has room for length + 1 bytes
+ * @param path the path
+ * @param length the length of the path
+ * @return the length of the result, -1 if a .. segment leaves the document root
+ */
+static long normalize_path(char *normalized, const char *path, size_t length) {
+	size_t i = 0, normalized_length = 0;
+	while(i < length) {
+		size_t start = i;
+		while(i < length && path[i] != '/') {
+			i++;
+		}
+		size_t segment_length = i - start;
+		i++;
+		if(segment_length == 0 || (segment_length == 1 && path[start] == '.')) {
+			continue;
+		}
+		if(segment_length == 2 && path[start] == '.' && path[start + 1] == '.') {
+			if(normalized_length == 0) {
+				return -1;
+			}
+			while(normalized[--normalized_length] != '/');
+			continue;
+		}
+		normalized[normalized_length++] = '/';
+		memcpy(normalized + normalized_length, path + start, segment_length);
+		normalized_length += segment_length;
+	}
+	return normalized_length;
+}
+
+/**
+ * @brief answers the request whose request line and headers were parsed by the given connection
+ * @details a file is not read, it is opened and sent with sendfile once the response is written. A request of
+ *          another version than HTTP/1.1 is answered with 400 and a request with a body of unknown length with 501,
+ *          both close the connection, because the start of the next request cannot be found reliably. If the client
+ *          accepts it, a precompressed sibling of the file with the suffix .br or .gz is sent instead of the file,
+ *          preferring brotli. Without a sibling, the file is compressed with gzip if compression is enabled. The
+ *          path is normalized first, so the file cache and the siblings are looked up by the same path for every
+ *          spelling of it, and a path that leaves the document root is answered with 400.
+ * @param connection the connection
+ * @param config the settings of the server
+ * @return true if a response has been created, false otherwise
+ */
+static bool handle_request(connection_t *connection, const server_config_t *config) {
+	const http_request_t *request = &connection->parsed;
+	connection->close_after_response = wants_close(connection);
+	if(!slice_equals(connection->request, request->version, "HTTP/1.1")) {
+		connection->close_after_response = true;
+		return prepare_response(connection, "400", "(Bad Request)", EMPTY_CONTENT_HEADERS);
+	}
+	if(request->has_transfer_encoding) {
+		connection->close_after_response = true;
+		return prepare_response(connection, "501", "(Not Implemented)", EMPTY_CONTENT_HEADERS);
+	}
+	if(!slice_equals(connection->request, request->method, "GET")) {
+		return prepare_response(connection, "501", "(Not Implemented)", EMPTY_CONTENT_HEADERS);
+	}
+	const char *request_path = connection->request + request->path.offset;
+	size_t index_length = strlen(config->index_filename);
+	size_t max_length = request->path.length > index_length ? request->path.length : index_length;
+
+	//the path has room for the / that normalize_path may add and for the suffix of a precompressed sibling
+	size_t doc_root_length = strlen(config->doc_root);
+	char full_file_path[doc_root_length + max_length + 8];
+	memcpy(full_file_path, "./", 2);
+	memcpy(full_file_path + 2, config->doc_root, doc_root_length);
+	size_t path_length = 2 + doc_root_length;
+	long normalized_length = normalize_path(full_file_path + path_length, request_path, request->path.length);
+	if(normalized_length == 0) {
+		normalized_length = normalize_path(full_file_path + path_length, config->index_filename, index_length);
+	}
+	if(normalized_length < 0) {
+		return prepare_response(connection, "400", "(Bad Request)", EMPTY_CONTENT_HEADERS);
+	}
+	path_length += normalized_length;
+	full_file_path[path_length] = '\0';
+	bool accepts_brotli = accepts_encoding(connection, "br");
+	bool accepts_gzip = accepts_encoding(connection, "gzip");
+
+	int served = 0;
+	if(accepts_brotli) {
+		strcpy(full_file_path + path_length, ".br");
+		served = serve_file(connection, config, full_file_path, "br");
+	}
+	if(served == 0 && accepts_gzip) {
+		strcpy(full_file_path + path_length, ".gz");
+		served = serve_file(connection, config, full_file_path, "gzip");
+	}
+	full_file_path[path_length] = '\0';
+	if(served == 0 && accepts_gzip && config->compress && config->cache != NULL) {
+		cache_entry_t *entry = acquire_cached_file(config->cache, full_file_path, CACHE_GZIP);
+		if(entry != NULL && entry->encoding != NULL) {
+			return serve_cached_file(connection, entry, entry->encoding);
+		}
+		if(entry != NULL) {
+			release_cached_file(entry);
+		}
+	}
+	if(served == 0) {
+		served = serve_file(connection, config, full_file_path, NULL);
+	}
+	if(served == 0) {
+		return prepare_response(connection, "404", "(Not Found)", EMPTY_CONTENT_HEADERS);
+	}
+	return served > 0;
+}
+
+/**
+ * @brief removes the given connection from the list of connections of the loop
+ * @param loop the event loop
+ * @param connection the connection
+ */
+static void unlink_connection(event_loop_t *loop, connection_t *connection) {
+	if(connection->previous != NULL) {
+		connection->previous->next = connection->next;
+	}else{
+		loop->oldest = connection->next;
+	}
+	if(connection->next != NULL) {
+		connection->next->previous = connection->previous;
+	}else{
+		loop->newest = connection->previous;
+	}
+	connection->previous = NULL;
+	connection->next = NULL;
+}
+
+/**
+ * @brief records that the given connection made progress, which moves it to the end of the list of connections
+ * @param loop the event loop
+ * @param connection the connection, it has to be in the list already unless it is new
+ */
+static void touch_connection(event_loop_t *loop, connection_t *connection) {
+	connection->last_active = now_ms();
+	if(loop->newest == connection) {
+		return;
+	}
+	if(connection->previous != NULL || loop->oldest == connection) {
+		unlink_connection(loop, connection);
+	}
+	connection->previous = loop->newest;
+	if(loop->newest != NULL) {
+		loop->newest->next = connection;
+	}else{
+		loop->oldest = connection;
+	}
+	loop->newest = connection;
+}
+
+/**
+ * @brief closes the given connection and frees its memory
+ * @details closing the socket also removes it from the epoll instance.
+ * @param loop the event loop
+ * @param connection the connection
+ */
+static void close_connection(event_loop_t *loop, connection_t *connection) {
+	unlink_connection(loop, connection);
+	close(connection->fd);
+	if(connection->file_fd != -1) {
+		close(connection->file_fd);
+	}
+	if(connection->cached != NULL) {
+		release_cached_file(connection->cached);
+	}
+	free(connection);
+}
+
+/**
+ * @brief changes the events the given connection waits for
+ * @param loop the event loop
+ * @param connection the connection
+ * @param writable true if the connection should wait until it is writable, false if it should wait for input
+ * @return true on success, false if the connection was closed because of an error
+ */
+static bool wait_for(event_loop_t *loop, connection_t *connection, bool writable) {
+	if(connection->waiting_writable == writable) {
+		return true;
+	}
+	struct epoll_event event;
+	event.events = writable ? EPOLLOUT : EPOLLIN | EPOLLRDHUP;
+	event.data.ptr = connection;
+	if(epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, connection->fd, &event) < 0) {
+		error_message(loop->config->programm_name, "Epoll error");
+		close_connection(loop, connection);
+		return false;
+	}
+	connection->waiting_writable = writable;
+	return true;
+}
+
+/**
+ * @brief accepts all pending connections of the listening socket and adds them to the epoll instance
+ * @param loop the event loop
+ */
+static void accept_connections(event_loop_t *loop) {
+	while(true) {
+		int connfd = accept4(loop->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if(connfd < 0) {
+			if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED) {
+				error_message(loop->config->programm_name, "Accept error");
+			}
+			if(errno != EINTR && errno != ECONNABORTED) {
+				return;
+			}
+			continue;
+		}
+		connection_t *connection = calloc(1, sizeof(connection_t));
+		if(connection == NULL) {
+			error_message(loop->config->programm_name, "memory allocation error");
+			close(connfd);
+			continue;
+		}
+		connection->fd = connfd;
+		connection->file_fd = -1;
+		connection->state = CONNECTION_READING;
+		touch_connection(loop, connection);
+		struct epoll_event event;
+		event.events = EPOLLIN | EPOLLRDHUP;
+		event.data.ptr = connection;
+		if(epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, connfd, &event) < 0) {
+			error_message(loop->config->programm_name, "Epoll error");
+			close_connection(loop, connection);
+		}
+	}
+}
+
+/**
+ * @brief prepares the given connection for its next request after a response has been written
+ * @details the bytes of pipelined requests that were read together with the current request are moved to the
+ *          start of the request buffer.
+ * @param connection the connection
+ */
+static void finish_request(connection_t *connection) {
+	if(connection->file_fd != -1) {
+		close(connection->file_fd);
+		connection->file_fd = -1;
+	}
+	if(connection->cached != NULL) {
+		release_cached_file(connection->cached);
+		connection->cached = NULL;
+	}
+	connection->body_offset = 0;
+	connection->body_end = 0;
+	connection->file_offset = 0;
+	connection->file_end = 0;
+	connection->request_length -= connection->request_consumed;
+	memmove(connection->request, connection->request + connection->request_consumed, connection->request_length);
+	connection->request_consumed = 0;
+	reset_request_parser(&connection->parsed);
+	connection->state = CONNECTION_READING;
+}
+
+/**
+ * @brief writes as much of the response of the given connection as the socket accepts
+ * @details the header and the content of a cached file are sent together with one gathering sendmsg. If a file
+ *          follows, the header is sent with MSG_MORE, so the kernel can put it and the start of the file into the
+ *          same packet. The file is sent with sendfile, so its content is never copied into user space. At most
+ *          SENDFILE_CHUNK_SIZE bytes of the file are sent per call, so one fast client that downloads a large file
+ *          cannot starve the other connections of the loop.
+ * @param loop the event loop
+ * @param connection the connection
+ * @return 1 if the response has been written and the connection is ready for its next request, 0 if the
+ *         connection waits until it is writable and -1 if it was closed
+ */
+static int write_response(event_loop_t *loop, connection_t *connection) {
+	size_t chunk_sent = 0;
+	bool would_block = false;
+	while(connection->header_sent < connection->header_length || connection->body_offset < connection->body_end) {
+		struct iovec iov[2];
+		struct msghdr message;
+		memset(&message, 0, sizeof(message));
+		message.msg_iov = iov;
+		if(connection->header_sent < connection->header_length) {
+			iov[message.msg_iovlen].iov_base = connection->header + connection->header_sent;
+			iov[message.msg_iovlen++].iov_len = connection->header_length - connection->header_sent;
+		}
+		if(connection->body_offset < connection->body_end) {
+			iov[message.msg_iovlen].iov_base = connection->cached->data + connection->body_offset;
+			iov[message.msg_iovlen++].iov_len = connection->body_end - connection->body_offset;
+		}
+		int flags = MSG_NOSIGNAL | (connection->file_offset < connection->file_end ? MSG_MORE : 0);
+		ssize_t written = sendmsg(connection->fd, &message, flags);
+		if(written < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			if(errno == EAGAIN || errno == EWOULDBLOCK) {
+				would_block = true;
+				break;
+			}
+			close_connection(loop, connection);
+			return -1;
+		}
+		size_t header_written = connection->header_length - connection->header_sent;
+		if(header_written > (size_t)written) {
+			header_written = written;
+		}
+		connection->header_sent += header_written;
+		connection->body_offset += written - header_written;
+		touch_connection(loop, connection);
+	}
+	while(!would_block && connection->file_offset < connection->file_end && chunk_sent < SENDFILE_CHUNK_SIZE) {
+		off_t remaining = connection->file_end - connection->file_offset;
+		size_t length = remaining < SENDFILE_CHUNK_SIZE - chunk_sent ? remaining : SENDFILE_CHUNK_SIZE - chunk_sent;
+		ssize_t written = sendfile(connection->fd, connection->file_fd, &connection->file_offset, length);
+		if(written < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			if(errno == EAGAIN || errno == EWOULDBLOCK) {
+				would_block = true;
+				break;
+			}
+			close_connection(loop, connection);
+			return -1;
+		}
+		if(written == 0) {
+			//the file was truncated while it was sent, the promised length cannot be delivered anymore
+			close_connection(loop, connection);
+			return -1;
+		}
+		chunk_sent += written;
+		touch_connection(loop, connection);
+	}
+	if(connection->header_sent == connection->header_length && connection->body_offset == connection->body_end &&
+			connection->file_offset == connection->file_end) {
+		if(connection->close_after_response) {
+			close_connection(loop, connection);
+			return -1;
+		}
+		finish_request(connection);
+		return 1;
+	}
+	return wait_for(loop, connection, true) ? 0 : -1;
+}
+
+/**
+ * @brief answers a request that cannot be parsed and closes the connection after the response
+ * @details the whole buffer counts as consumed, because the start of the next request cannot be found reliably.
+ * @param connection the connection
+ * @param status the response status
+ * @param status_message the response status message
+ * @return true if the response has been created, false otherwise
+ */
+static bool reject_request(connection_t *connection, char *status, char *status_message) {
+	connection->close_after_response = true;
+	connection->request_consumed = connection->request_length;
+	connection->body_remaining = 0;
+	return prepare_response(connection, status, status_message, EMPTY_CONTENT_HEADERS);
+}
+
+/**
+ * @brief reads and answers the requests of the given connection as far as they are available
+ * @details the request line and the headers are collected in the request buffer and parsed incrementally after
+ *          every read. A request that is malformed is answered with 400, a request whose headers do not fit into
+ *          the buffer with 431. The body is discarded in reads of up to DRAIN_BUFFER_SIZE bytes, because only GET
+ *          requests are served. Requests are answered one after the other in the order they were sent, the next
+ *          request is only parsed once the response to the previous one has been written.
+ * @param loop the event loop
+ * @param connection the connection, it is closed if the client closed it or an error occured
+ */
+static void read_request(event_loop_t *loop, connection_t *connection) {
+	char discard[DRAIN_BUFFER_SIZE];
+	while(true) {
+		if(connection->state == CONNECTION_WRITING) {
+			if(write_response(loop, connection) <= 0) {
+				return;
+			}
+			continue;
+		}
+		if(connection->state == CONNECTION_READING) {
+			bool prepared = true;
+			switch(parse_request(&connection->parsed, connection->request, connection->request_length)) {
+				case PARSE_COMPLETE: {
+					//bytes after the headers belong to the body first, then to pipelined requests
+					const http_request_t *request = &connection->parsed;
+					size_t buffered = connection->request_length - request->length;
+					unsigned long content_length = request->has_transfer_encoding ? 0 : request->content_length;
+					size_t body_buffered = content_length < buffered ? content_length : buffered;
+					connection->request_consumed = request->length + body_buffered;
+					connection->body_remaining = content_length - body_buffered;
+					prepared = handle_request(connection, loop->config);
+					break;
+				}
+				case PARSE_MALFORMED:
+					prepared = reject_request(connection, "400", "(Bad Request)");
+					break;
+				case PARSE_TOO_LARGE:
+					prepared = reject_request(connection, "431", "(Request Header Fields Too Large)");
+					break;
+				case PARSE_INCOMPLETE:
+					if(connection->request_length < REQUEST_BUFFER_SIZE) {
+						break;
+					}
+					prepared = reject_request(connection, "431", "(Request Header Fields Too Large)");
+					break;
+			}
+			if(!prepared) {
+				close_connection(loop, connection);
+				return;
+			}
+			if(connection->request_consumed > 0) {
+				connection->state = connection->body_remaining > 0 ? CONNECTION_DRAINING : CONNECTION_WRITING;
+				continue;
+			}
+		}
+		if(!wait_for(loop, connection, false)) {
+			return;
+		}
+
+		ssize_t received;
+		if(connection->state == CONNECTION_READING) {
+			received = read(connection->fd, connection->request + connection->request_length,
+					REQUEST_BUFFER_SIZE - connection->request_length);
+		}else{
+			size_t length = connection->body_remaining < sizeof(discard) ? connection->body_remaining : sizeof(discard);
+			received = read(connection->fd, discard, length);
+		}
+		if(received < 0 && errno == EINTR) {
+			continue;
+		}
+		if(received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			return;
+		}
+		if(received <= 0) {
+			close_connection(loop, connection);
+			return;
+		}
+		touch_connection(loop, connection);
+		if(connection->state == CONNECTION_READING) {
+			connection->request_length += received;
+		}else{
+			connection->body_remaining -= received;
+			if(connection->body_remaining == 0) {
+				connection->state = CONNECTION_WRITING;
+			}
+		}
+	}
+}
+
+/**
+ * @brief closes the connections that made no progress for IDLE_TIMEOUT_MS
+ * @param loop the event loop
+ * @return the number of milliseconds until the next connection times out, or -1 if there are no connections
+ */
+static int close_idle_connections(event_loop_t *loop) {
+	long long now = now_ms();
+	while(loop->oldest != NULL && now - loop->oldest->last_active >= IDLE_TIMEOUT_MS) {
+		close_connection(loop, loop->oldest);
+	}
+	return loop->oldest == NULL ? -1 : (int)(loop->oldest->last_active + IDLE_TIMEOUT_MS - now);
+}
+
+int run_event_loop(int listen_fd, int quit_fd, const server_config_t *config) {
+	int flags = fcntl(listen_fd, F_GETFL);
+	if(flags < 0 || fcntl(listen_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+		error_message(config->programm_name, "Fcntl error");
+		return -1;
+	}
+	event_loop_t loop;
+	memset(&loop, 0, sizeof(loop));
+	loop.listen_fd = listen_fd;
+	loop.config = config;
+	loop.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if(loop.epoll_fd < 0) {
+		error_message(config->programm_name, "Epoll error");
+		return -1;
+	}
+	//the listening socket and the quit descriptor are the only entries without a connection
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.ptr = NULL;
+	struct epoll_event quit_event;
+	quit_event.events = EPOLLIN;
+	quit_event.data.ptr = &quit_event;
+	if(epoll_ctl(loop.epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) < 0 ||
+			epoll_ctl(loop.epoll_fd, EPOLL_CTL_ADD, quit_fd, &quit_event) < 0) {
+		error_message(config->programm_name, "Epoll error");
+		close(loop.epoll_fd);
+		return -1;
+	}
+
+	struct epoll_event events[MAX_EVENTS];
+	int result = 0;
+	bool quit = false;
+	while(!quit) {
+		int count = epoll_wait(loop.epoll_fd, events, MAX_EVENTS, close_idle_connections(&loop));
+		if(count < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			error_message(config->programm_name, "Epoll error");
+			result = -1;
+			break;
+		}
+		int i;
+		for(i = 0; i < count; i++) {
+			connection_t *connection = events[i].data.ptr;
+			if(connection == NULL) {
+				accept_connections(&loop);
+			}else if(events[i].data.ptr == &quit_event) {
+				quit = true;
+			}else{
+				read_request(&loop, connection);
+			}
+		}
+	}
+	while(loop.oldest != NULL) {
+		close_connection(&loop, loop.oldest);
+	}
+	close(loop.epoll_fd);
+	return result;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file
+ * @brief event_loop module serves the connections of a listening socket with a non-blocking epoll event loop
+ *
+ * @author Benjamin Deutsch (12215881)
+ * @date 23.12.2023
+ */
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include "file_cache.h"
+#include "http_parser.h"
+
+#define REQUEST_BUFFER_SIZE 8192 //the maximum size of the request line and the headers of a request in bytes
+#define DRAIN_BUFFER_SIZE 65536 //the maximum number of bytes of a request body that are discarded per read
+#define MAX_EVENTS 256 //the maximum number of events that are handled per call of epoll_wait
+#define RESPONSE_HEADER_SIZE 512 //the maximum size of the status line and the headers of a response in bytes
+#define SENDFILE_CHUNK_SIZE (1 << 20) //the maximum number of bytes of a file that are sent per event
+#define HTTP_DATE_SIZE 32 //the size of a buffer that holds a formatted http date
+#define EMPTY_CONTENT_HEADERS "Content-Length: 0\r\n" //the headers of a response without content
+#define IDLE_TIMEOUT_MS 10000 //connections that neither sent nor received anything for this long are closed
+
+/**
+ * @brief the state of a connection
+ * @details a connection reads the request line and the headers, discards the body of the request and writes the
+ *          response. Afterwards it reads the next request of the connection, unless the client asked to close it
+ *          or the request was malformed.
+ */
+typedef enum connection_state {
+	CONNECTION_READING,
+	CONNECTION_DRAINING,
+	CONNECTION_WRITING
+} connection_state_t;
+
+/**
+ * @brief a connection of a client
+ * @details request holds the bytes that were read so far. It can contain pipelined requests after the current
+ *          one, request_consumed is the number of bytes that belong to the current request. parsed is the request
+ *          line and the headers of the current request, which are parsed as far as they were read. body_remaining
+ *          is the number of bytes of the request body that still have to be discarded. header is the status line
+ *          and the headers of the response, of which header_sent bytes have been written. They are followed by the
+ *          bytes of the cached file from body_offset to body_end or by the bytes of file_fd from file_offset to
+ *          file_end, which is a part of the file if a range was requested. cached is NULL and file_fd is -1 if the
+ *          response has no such content. waiting_writable is true if the connection waits for EPOLLOUT and
+ *          close_after_response is true if the connection is closed once the response has been written. The
+ *          connections of an event loop are kept in a list ordered by last_active, the monotonic time of their last
+ *          progress in milliseconds.
+ */
+typedef struct connection {
+	int fd;
+	connection_state_t state;
+	char request[REQUEST_BUFFER_SIZE];
+	size_t request_length;
+	size_t request_consumed;
+	http_request_t parsed;
+	unsigned long body_remaining;
+	char header[RESPONSE_HEADER_SIZE];
+	size_t header_length;
+	size_t header_sent;
+	cache_entry_t *cached;
+	size_t body_offset;
+	size_t body_end;
+	int file_fd;
+	off_t file_offset;
+	off_t file_end;
+	bool waiting_writable;
+	bool close_after_response;
+	long long last_active;
+	struct connection *previous;
+	struct connection *next;
+} connection_t;
+
+/**
+ * @brief the settings of the server that are needed to answer requests
+ * @details cache is shared by all event loops, it is NULL if files are not cached. compress is true if files are
+ *          compressed with gzip for clients that accept it, which needs the cache to hold the compressed files.
+ */
+typedef struct server_config {
+	char *programm_name;
+	char *doc_root;
+	char *index_filename;
+	file_cache_t *cache;
+	bool compress;
+} server_config_t;
+
+/**
+ * @brief accepts and serves the connections of the given listening socket until the quit descriptor is readable
+ * @details the listening socket and all connections are non-blocking and are watched with one epoll instance, so
+ *          a single thread serves any number of concurrent connections and a slow client does not stall the
+ *          others. Connections are kept alive between requests, pipelined requests are answered in order and
+ *          connections that are idle for IDLE_TIMEOUT_MS are closed. Several loops can run in parallel threads, each
+ *          with its own listening socket. They share the read-only config, the quit descriptor and the file cache of
+ *          the config, which synchronizes its own accesses.
+ * @param listen_fd the listening socket, it is set to non-blocking
+ * @param quit_fd a descriptor that becomes readable when the server should quit, e.g. an eventfd. It is never
+ *                read, so it wakes every loop that watches it
+ * @param config the settings of the server
+ * @return 0 if the loop stopped because of the quit descriptor, -1 if an error occured
+ */
+int run_event_loop(int listen_fd, int quit_fd, const server_config_t *config);
+
+#endif /* EVENT_LOOP_H */
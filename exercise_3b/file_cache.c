@@ -0,0 +1,444 @@
+#include "file_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <limits.h>
+#include <zlib.h>
+
+/**
+ * @brief returns the current monotonic time in milliseconds
+ * @return the time
+ */
+static long long now_ms(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief returns the FNV-1a hash of the given path and variant
+ * @param path the path
+ * @param variant the variant
+ * @return the hash
+ */
+static uint64_t hash_path(const char *path, cache_variant_t variant) {
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	while(*path != '\0') {
+		hash = (hash ^ (unsigned char)*path++) * 0x100000001b3ULL;
+	}
+	return (hash ^ variant) * 0x100000001b3ULL;
+}
+
+/**
+ * @brief returns the number of bytes the given entry uses
+ * @param entry the entry
+ * @return the number of bytes
+ */
+static size_t entry_memory(const cache_entry_t *entry) {
+	return sizeof(cache_entry_t) + entry->size + strlen(entry->path) + 1;
+}
+
+/**
+ * @brief frees the memory of the given entry
+ * @param entry the entry
+ */
+static void free_entry(cache_entry_t *entry) {
+	free(entry->path);
+	free(entry->data);
+	free(entry);
+}
+
+file_cache_t* create_file_cache(size_t budget) {
+	file_cache_t *cache = calloc(1, sizeof(file_cache_t));
+	if(cache == NULL) {
+		return NULL;
+	}
+	//a power of two, so the bucket of a hash is selected with a mask
+	size_t expected_entries = budget / CACHE_AVERAGE_FILE_SIZE + MAX_MISSING_ENTRIES;
+	cache->bucket_count = 1;
+	while(cache->bucket_count < expected_entries) {
+		cache->bucket_count *= 2;
+	}
+	cache->buckets = calloc(cache->bucket_count, sizeof(cache_entry_t*));
+	if(cache->buckets == NULL || pthread_rwlock_init(&cache->lock, NULL) != 0) {
+		free(cache->buckets);
+		free(cache);
+		return NULL;
+	}
+	cache->budget = budget;
+	cache->max_file_size = budget / 8;
+	return cache;
+}
+
+void format_etag(char *etag, const struct stat *file_stat) {
+	snprintf(etag, ETAG_SIZE, "\"%llx-%llx-%llx.%lx\"", (unsigned long long)file_stat->st_ino,
+			(unsigned long long)file_stat->st_size, (unsigned long long)file_stat->st_mtim.tv_sec,
+			(unsigned long)file_stat->st_mtim.tv_nsec);
+}
+
+int format_file_headers(char *headers, size_t size, const struct stat *file_stat) {
+	char last_modified[32];
+	struct tm utc;
+	gmtime_r(&file_stat->st_mtim.tv_sec, &utc);
+	strftime(last_modified, sizeof(last_modified), "%a, %d %b %Y %H:%M:%S GMT", &utc);
+	char etag[ETAG_SIZE];
+	format_etag(etag, file_stat);
+	int length = snprintf(headers, size, "Last-Modified: %s\r\nETag: %s\r\nAccept-Ranges: bytes\r\n",
+			last_modified, etag);
+	return length < 0 || (size_t)length >= size ? -1 : length;
+}
+
+/**
+ * @brief returns the bucket of the hash table that holds the entries with the given hash
+ * @param cache the cache
+ * @param hash the hash
+ * @return the bucket
+ */
+static cache_entry_t** get_bucket(file_cache_t *cache, uint64_t hash) {
+	return &cache->buckets[hash & (cache->bucket_count - 1)];
+}
+
+/**
+ * @brief returns the clock that holds the given entry
+ * @param cache the cache
+ * @param entry the entry
+ * @return the clock of the existing files or the clock of the missing files
+ */
+static cache_clock_t* get_clock(file_cache_t *cache, const cache_entry_t *entry) {
+	return entry->exists ? &cache->clock : &cache->missing;
+}
+
+/**
+ * @brief returns the entry of the given path and variant
+ * @details the caller has to hold the lock of the cache.
+ * @param cache the cache
+ * @param path the path
+ * @param variant the variant
+ * @param hash the hash of the path and the variant
+ * @return the entry or NULL if the path is not cached
+ */
+static cache_entry_t* find_entry(file_cache_t *cache, const char *path, cache_variant_t variant, uint64_t hash) {
+	cache_entry_t *entry = *get_bucket(cache, hash);
+	while(entry != NULL && (entry->hash != hash || entry->variant != variant || strcmp(entry->path, path) != 0)) {
+		entry = entry->next;
+	}
+	return entry;
+}
+
+/**
+ * @brief removes the given entry from the cache and releases the reference of the cache
+ * @details the caller has to hold the write lock of the cache. The last entry of the clock takes the place of the
+ *          removed one.
+ * @param cache the cache
+ * @param entry the entry
+ */
+static void remove_entry(file_cache_t *cache, cache_entry_t *entry) {
+	cache_entry_t **link = get_bucket(cache, entry->hash);
+	while(*link != entry) {
+		link = &(*link)->next;
+	}
+	*link = entry->next;
+	cache_clock_t *clock = get_clock(cache, entry);
+	clock->count--;
+	clock->entries[entry->clock_index] = clock->entries[clock->count];
+	clock->entries[entry->clock_index]->clock_index = entry->clock_index;
+	if(clock->hand >= clock->count) {
+		clock->hand = 0;
+	}
+	if(entry->exists) {
+		cache->used -= entry_memory(entry);
+	}
+	release_cached_file(entry);
+}
+
+/**
+ * @brief returns the next entry of the given clock that should be evicted
+ * @details uses the CLOCK algorithm: the hand passes the entries in a circle, an entry that was used since the hand
+ *          passed it the last time gets another round, the first other entry is returned. The caller has to hold
+ *          the write lock of the cache.
+ * @param clock the clock, it must not be empty
+ * @return the entry
+ */
+static cache_entry_t* find_victim(cache_clock_t *clock) {
+	cache_entry_t *entry = clock->entries[clock->hand];
+	while(__atomic_exchange_n(&entry->referenced, false, __ATOMIC_RELAXED)) {
+		clock->hand = (clock->hand + 1) % clock->count;
+		entry = clock->entries[clock->hand];
+	}
+	return entry;
+}
+
+/**
+ * @brief evicts entries until the given entry fits into the cache
+ * @details entries of existing files are evicted until the memory of the entry fits into the budget, entries of
+ *          missing files until there is room for another one. The caller has to hold the write lock of the cache.
+ * @param cache the cache
+ * @param entry the entry that should be inserted
+ */
+static void evict_entries(file_cache_t *cache, const cache_entry_t *entry) {
+	if(entry->exists) {
+		size_t needed = entry_memory(entry);
+		while(cache->clock.count > 0 && cache->used + needed > cache->budget) {
+			remove_entry(cache, find_victim(&cache->clock));
+		}
+	}else{
+		while(cache->missing.count >= MAX_MISSING_ENTRIES) {
+			remove_entry(cache, find_victim(&cache->missing));
+		}
+	}
+}
+
+/**
+ * @brief adds the given entry to the cache, replacing an older entry of the same path and variant
+ * @details the caller has to hold the write lock of the cache.
+ * @param cache the cache
+ * @param entry the entry, the cache takes over one of its references if it was added
+ * @return true if the entry was added, false if a memory allocation error occured
+ */
+static bool insert_entry(file_cache_t *cache, cache_entry_t *entry) {
+	cache_entry_t *existing = find_entry(cache, entry->path, entry->variant, entry->hash);
+	if(existing != NULL) {
+		remove_entry(cache, existing);
+	}
+	evict_entries(cache, entry);
+	cache_clock_t *clock = get_clock(cache, entry);
+	if(clock->count == clock->capacity) {
+		size_t capacity = clock->capacity * 2 + 64;
+		cache_entry_t **entries = realloc(clock->entries, capacity * sizeof(cache_entry_t*));
+		if(entries == NULL) {
+			return false;
+		}
+		clock->entries = entries;
+		clock->capacity = capacity;
+	}
+	cache_entry_t **bucket = get_bucket(cache, entry->hash);
+	entry->next = *bucket;
+	*bucket = entry;
+	entry->clock_index = clock->count;
+	clock->entries[clock->count++] = entry;
+	if(entry->exists) {
+		cache->used += entry_memory(entry);
+	}
+	return true;
+}
+
+/**
+ * @brief replaces the data of the given entry by its gzip compressed form
+ * @details the data is dropped instead if compressing it does not save at least an eighth of its size, e.g. because
+ *          the file is compressed already, so that the file is sent uncompressed. The file is compressed with the
+ *          default level, because a miss compresses it on the thread of an event loop, which serves no other
+ *          connection in the meantime.
+ * @param entry the entry
+ * @return true on success, false if an error occured
+ */
+static bool compress_entry(cache_entry_t *entry) {
+	if(entry->size > UINT_MAX) {
+		return false;
+	}
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	//15 + 16 selects a 32 KiB window with a gzip header and trailer
+	if(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		return false;
+	}
+	uLong bound = deflateBound(&stream, entry->size);
+	char *compressed = malloc(bound);
+	if(compressed == NULL) {
+		deflateEnd(&stream);
+		return false;
+	}
+	stream.next_in = (Bytef*)entry->data;
+	stream.avail_in = entry->size;
+	stream.next_out = (Bytef*)compressed;
+	stream.avail_out = bound;
+	int result = deflate(&stream, Z_FINISH);
+	size_t compressed_size = stream.total_out;
+	deflateEnd(&stream);
+	if(result != Z_STREAM_END) {
+		free(compressed);
+		return false;
+	}
+	free(entry->data);
+	if(compressed_size < entry->size - entry->size / 8) {
+		char *shrunk = realloc(compressed, compressed_size);
+		entry->data = shrunk != NULL ? shrunk : compressed;
+		entry->size = compressed_size;
+		entry->encoding = "gzip";
+	}else{
+		free(compressed);
+		entry->data = NULL;
+		entry->size = 0;
+	}
+	return true;
+}
+
+/**
+ * @brief creates the entry of a path at which there is no file
+ * @param path the path
+ * @param variant the variant
+ * @param hash the hash of the path and the variant
+ * @return the entry with a reference count of 1, or NULL if a memory allocation error occured
+ */
+static cache_entry_t* create_missing_entry(const char *path, cache_variant_t variant, uint64_t hash) {
+	cache_entry_t *entry = calloc(1, sizeof(cache_entry_t));
+	if(entry == NULL) {
+		return NULL;
+	}
+	entry->path = strdup(path);
+	if(entry->path == NULL) {
+		free(entry);
+		return NULL;
+	}
+	entry->variant = variant;
+	entry->hash = hash;
+	entry->checked = now_ms();
+	entry->references = 1;
+	return entry;
+}
+
+/**
+ * @brief reads the file at the given path into a new entry
+ * @param path the path of the file
+ * @param variant the variant of the entry
+ * @param hash the hash of the path and the variant
+ * @param max_size the size of the largest file that may be read
+ * @return the entry with a reference count of 1, or NULL if the file cannot be cached
+ */
+static cache_entry_t* load_entry(const char *path, cache_variant_t variant, uint64_t hash, size_t max_size) {
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0) {
+		return errno == ENOENT || errno == ENOTDIR ? create_missing_entry(path, variant, hash) : NULL;
+	}
+	struct stat file_stat;
+	if(fstat(fd, &file_stat) < 0 || !S_ISREG(file_stat.st_mode) || (size_t)file_stat.st_size > max_size) {
+		close(fd);
+		return NULL;
+	}
+	cache_entry_t *entry = calloc(1, sizeof(cache_entry_t));
+	if(entry == NULL) {
+		close(fd);
+		return NULL;
+	}
+	//a CACHE_GZIP entry of a file that is too large to be compressed holds no data, so the file is sent uncompressed
+	bool uncompressed = variant == CACHE_GZIP && file_stat.st_size > MAX_COMPRESSED_FILE_SIZE;
+	entry->size = uncompressed ? 0 : (size_t)file_stat.st_size;
+	entry->path = strdup(path);
+	entry->data = uncompressed ? NULL : malloc(entry->size > 0 ? entry->size : 1);
+	size_t loaded = 0;
+	while(entry->path != NULL && entry->data != NULL && loaded < entry->size) {
+		ssize_t received = read(fd, entry->data + loaded, entry->size - loaded);
+		if(received < 0 && errno == EINTR) {
+			continue;
+		}
+		if(received <= 0) {
+			break;
+		}
+		loaded += received;
+	}
+	close(fd);
+	//a file that shrank while it was read is not cached
+	if(entry->path == NULL || (!uncompressed && (entry->data == NULL || loaded < entry->size ||
+			(variant == CACHE_GZIP && !compress_entry(entry))))) {
+		free_entry(entry);
+		return NULL;
+	}
+	//the headers describe the content of the entry, which is shorter than the file if it was compressed, so the
+	//compressed content has its own entity tag
+	struct stat content_stat = file_stat;
+	content_stat.st_size = entry->size;
+	int headers_length = format_file_headers(entry->headers, sizeof(entry->headers), &content_stat);
+	if(headers_length < 0) {
+		free_entry(entry);
+		return NULL;
+	}
+	format_etag(entry->etag, &content_stat);
+	entry->variant = variant;
+	entry->hash = hash;
+	entry->exists = true;
+	entry->headers_length = headers_length;
+	entry->mtime = file_stat.st_mtim;
+	entry->file_size = file_stat.st_size;
+	entry->inode = file_stat.st_ino;
+	entry->checked = now_ms();
+	entry->references = 1;
+	return entry;
+}
+
+/**
+ * @brief returns whether the given entry still matches the file at its path
+ * @param entry the entry
+ * @return true if the file did not change, false otherwise
+ */
+static bool is_current(const cache_entry_t *entry) {
+	struct stat file_stat;
+	if(stat(entry->path, &file_stat) < 0) {
+		return !entry->exists && (errno == ENOENT || errno == ENOTDIR);
+	}
+	return entry->exists && S_ISREG(file_stat.st_mode) && file_stat.st_ino == entry->inode &&
+			file_stat.st_size == entry->file_size && file_stat.st_mtim.tv_sec == entry->mtime.tv_sec &&
+			file_stat.st_mtim.tv_nsec == entry->mtime.tv_nsec;
+}
+
+cache_entry_t* acquire_cached_file(file_cache_t *cache, const char *path, cache_variant_t variant) {
+	uint64_t hash = hash_path(path, variant);
+	pthread_rwlock_rdlock(&cache->lock);
+	cache_entry_t *entry = find_entry(cache, path, variant, hash);
+	if(entry != NULL) {
+		__atomic_add_fetch(&entry->references, 1, __ATOMIC_RELAXED);
+		__atomic_store_n(&entry->referenced, true, __ATOMIC_RELAXED);
+	}
+	pthread_rwlock_unlock(&cache->lock);
+
+	if(entry != NULL) {
+		long long now = now_ms();
+		if(now - __atomic_load_n(&entry->checked, __ATOMIC_RELAXED) < CACHE_REVALIDATE_MS) {
+			return entry;
+		}
+		if(is_current(entry)) {
+			__atomic_store_n(&entry->checked, now, __ATOMIC_RELAXED);
+			return entry;
+		}
+		//the file changed, the entry is dropped unless another thread replaced it already
+		pthread_rwlock_wrlock(&cache->lock);
+		if(find_entry(cache, path, variant, hash) == entry) {
+			remove_entry(cache, entry);
+		}
+		pthread_rwlock_unlock(&cache->lock);
+		release_cached_file(entry);
+	}
+
+	entry = load_entry(path, variant, hash, cache->max_file_size);
+	if(entry == NULL) {
+		return NULL;
+	}
+	pthread_rwlock_wrlock(&cache->lock);
+	if(insert_entry(cache, entry)) {
+		__atomic_add_fetch(&entry->references, 1, __ATOMIC_RELAXED);
+	}
+	pthread_rwlock_unlock(&cache->lock);
+	return entry;
+}
+
+void release_cached_file(cache_entry_t *entry) {
+	if(__atomic_sub_fetch(&entry->references, 1, __ATOMIC_ACQ_REL) == 0) {
+		free_entry(entry);
+	}
+}
+
+void free_file_cache(file_cache_t *cache) {
+	while(cache->clock.count > 0) {
+		remove_entry(cache, cache->clock.entries[0]);
+	}
+	while(cache->missing.count > 0) {
+		remove_entry(cache, cache->missing.entries[0]);
+	}
+	pthread_rwlock_destroy(&cache->lock);
+	free(cache->clock.entries);
+	free(cache->missing.entries);
+	free(cache->buckets);
+	free(cache);
+}
@@ -0,0 +1,157 @@
+/**
+ * @file
+ * @brief file_cache module keeps the contents of frequently served files in memory
+ *
+ * @author Benjamin Deutsch (12215881)
+ * @date 23.12.2023
+ */
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#define DEFAULT_CACHE_BUDGET (64L << 20) //the default number of bytes the cache may use
+#define CACHE_AVERAGE_FILE_SIZE 8192 //the expected size of a cached file, which sizes the hash table
+#define MAX_COMPRESSED_FILE_SIZE (1L << 20) //larger files are sent uncompressed instead of compressed on the fly
+#define MAX_MISSING_ENTRIES 1024 //the maximum number of entries of paths at which there is no file
+#define CACHE_REVALIDATE_MS 1000 //an entry is checked against its file at most this often
+#define FILE_HEADERS_SIZE 256 //the maximum size of the headers that describe a file in bytes
+#define ETAG_SIZE 64 //the maximum size of an entity tag including its quotes and the null byte
+
+/**
+ * @brief the representation of a file that a cache entry holds
+ * @details CACHE_GZIP entries are compressed with gzip when they are loaded, so a file is compressed once and not
+ *          for every response. Files larger than MAX_COMPRESSED_FILE_SIZE are not compressed, because that happens
+ *          on the thread of an event loop.
+ */
+typedef enum cache_variant {
+	CACHE_PLAIN,
+	CACHE_GZIP
+} cache_variant_t;
+
+/**
+ * @brief a file whose content is held in memory
+ * @details an entry is identified by the path and the variant of its file. headers are the precomputed response
+ *          headers that describe the content and etag is its entity tag, see format_file_headers. exists is false if
+ *          there is no file at the path, so requests for missing files, e.g. the compressed siblings of a file, do
+ *          not touch the file system either. encoding is the Content-Encoding of data, it is NULL for CACHE_PLAIN
+ *          entries and for CACHE_GZIP entries whose file does not shrink when it is compressed or is larger than
+ *          MAX_COMPRESSED_FILE_SIZE, which hold no data then. An entry is freed once it was removed from the cache
+ *          and all its references were released, so a connection can keep sending an entry that was evicted in the
+ *          meantime. mtime, file_size and inode are compared with the file to detect changes, checked is the
+ *          monotonic time in milliseconds of the last comparison. referenced is the bit of the CLOCK eviction and
+ *          clock_index the position of the entry in its clock of the cache.
+ */
+typedef struct cache_entry {
+	struct cache_entry *next;
+	char *path;
+	cache_variant_t variant;
+	uint64_t hash;
+	bool exists;
+	const char *encoding;
+	char *data;
+	size_t size;
+	char headers[FILE_HEADERS_SIZE];
+	size_t headers_length;
+	char etag[ETAG_SIZE];
+	struct timespec mtime;
+	off_t file_size;
+	ino_t inode;
+	long long checked;
+	unsigned int references;
+	bool referenced;
+	size_t clock_index;
+} cache_entry_t;
+
+/**
+ * @brief entries of a cache in the order the hand of the CLOCK eviction passes them
+ */
+typedef struct cache_clock {
+	cache_entry_t **entries;
+	size_t count;
+	size_t capacity;
+	size_t hand;
+} cache_clock_t;
+
+/**
+ * @brief a cache of file contents with a limit on its memory usage
+ * @details the cache can be shared by all worker threads. Lookups only take the read lock, inserting and evicting
+ *          entries takes the write lock. buckets is a hash table of the entries by path and variant with
+ *          bucket_count buckets, a power of two. clock holds the entries of existing files and missing the entries
+ *          of paths at which there is no file, each evicted with its own CLOCK hand. used is the memory of the
+ *          entries in clock in bytes, which is kept below budget. missing holds at most MAX_MISSING_ENTRIES entries
+ *          and does not count towards the budget, so requests for many different missing paths cannot evict the
+ *          hot files. Files larger than max_file_size are not cached.
+ */
+typedef struct file_cache {
+	pthread_rwlock_t lock;
+	cache_entry_t **buckets;
+	size_t bucket_count;
+	cache_clock_t clock;
+	cache_clock_t missing;
+	size_t budget;
+	size_t used;
+	size_t max_file_size;
+} file_cache_t;
+
+/**
+ * @brief creates an empty cache
+ * @details a single file may use at most an eighth of the budget, so one large file cannot evict the whole hot set.
+ *          The hash table has a bucket for every CACHE_AVERAGE_FILE_SIZE bytes of the budget and every missing entry.
+ * @param budget the number of bytes the cache may use
+ * @return the cache or NULL if a memory allocation error occured
+ */
+file_cache_t* create_file_cache(size_t budget);
+
+/**
+ * @brief formats the entity tag of the given file
+ * @details the tag is strong and is derived from the inode, the size and the modification time of the file, so it
+ *          changes whenever the file is replaced or modified.
+ * @param etag the buffer the tag is written to, it has to hold at least ETAG_SIZE bytes
+ * @param file_stat the status of the file
+ */
+void format_etag(char *etag, const struct stat *file_stat);
+
+/**
+ * @brief formats the response headers that describe the given file
+ * @details the headers are Last-Modified, ETag and Accept-Ranges. Content-Length is not part of them, because it
+ *          depends on the range of the file that is sent.
+ * @param headers the buffer the headers are written to
+ * @param size the size of the buffer
+ * @param file_stat the status of the file
+ * @return the length of the headers, or -1 if they do not fit into the buffer
+ */
+int format_file_headers(char *headers, size_t size, const struct stat *file_stat);
+
+/**
+ * @brief returns the cached content of the file at the given path and loads it if it is not cached yet
+ * @details the entry is checked against the file if it was not checked for CACHE_REVALIDATE_MS and is reloaded if
+ *          the modification time, the size or the inode of the file changed or the file was created or deleted.
+ *          Loading a file may evict the entries that were not used for the longest time. The returned entry has to
+ *          be released with release_cached_file.
+ * @param cache the cache
+ * @param path the path of the file
+ * @param variant the representation of the file
+ * @return the entry, whose exists is false if there is no file at the path, or NULL if the file is not a regular
+ *         file, is too large to be cached or an error occured. The file should be served without the cache then
+ */
+cache_entry_t* acquire_cached_file(file_cache_t *cache, const char *path, cache_variant_t variant);
+
+/**
+ * @brief releases an entry that was returned by acquire_cached_file
+ * @param entry the entry
+ */
+void release_cached_file(cache_entry_t *entry);
+
+/**
+ * @brief frees the given cache and all entries that are not referenced anymore
+ * @param cache the cache
+ */
+void free_file_cache(file_cache_t *cache);
+
+#endif /* FILE_CACHE_H */
@@ -0,0 +1,241 @@
+#include "http_parser.h"
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+
+/**
+ * @brief returns whether the given slice equals the given string, ignoring case
+ * @param buffer the buffer of the slice
+ * @param slice the slice
+ * @param string the string, terminated by a null byte
+ * @return true if the slice equals the string, false otherwise
+ */
+static bool slice_equals_ignore_case(const char *buffer, http_slice_t slice, const char *string) {
+	return strlen(string) == slice.length && strncasecmp(buffer + slice.offset, string, slice.length) == 0;
+}
+
+bool slice_equals(const char *buffer, http_slice_t slice, const char *string) {
+	return strlen(string) == slice.length && memcmp(buffer + slice.offset, string, slice.length) == 0;
+}
+
+/**
+ * @brief creates the slice of the given bytes
+ * @param buffer the buffer
+ * @param start the first byte of the slice
+ * @param end the byte after the slice
+ * @return the slice
+ */
+static http_slice_t make_slice(const char *buffer, const char *start, const char *end) {
+	http_slice_t slice;
+	slice.offset = start - buffer;
+	slice.length = end - start;
+	return slice;
+}
+
+void reset_request_parser(http_request_t *request) {
+	request->parsed = 0;
+	request->request_line_parsed = false;
+	request->header_count = 0;
+	request->has_content_length = false;
+	request->content_length = 0;
+	request->has_transfer_encoding = false;
+	request->length = 0;
+}
+
+/**
+ * @brief parses the request line of a request
+ * @details the request line consists of the method, the path and the version, separated by single spaces.
+ * @param request the request
+ * @param buffer the buffer
+ * @param line the start of the line
+ * @param end the end of the line without the line break
+ * @return true on success, false if the line is malformed
+ */
+static bool parse_request_line(http_request_t *request, const char *buffer, const char *line, const char *end) {
+	const char *first = memchr(line, ' ', end - line);
+	if(first == NULL || first == line) {
+		return false;
+	}
+	const char *second = memchr(first + 1, ' ', end - first - 1);
+	if(second == NULL || second == first + 1 || second + 1 == end ||
+			memchr(second + 1, ' ', end - second - 1) != NULL) {
+		return false;
+	}
+	request->method = make_slice(buffer, line, first);
+	request->path = make_slice(buffer, first + 1, second);
+	request->version = make_slice(buffer, second + 1, end);
+	return true;
+}
+
+/**
+ * @brief parses the value of a Content-Length header
+ * @param request the request
+ * @param value the start of the value
+ * @param end the end of the value
+ * @return true on success, false if the value is not a number or differs from an earlier Content-Length
+ */
+static bool parse_content_length(http_request_t *request, const char *value, const char *end) {
+	if(value == end) {
+		return false;
+	}
+	unsigned long content_length = 0;
+	for(; value < end; value++) {
+		if(*value < '0' || *value > '9' || content_length > (ULONG_MAX - (*value - '0')) / 10) {
+			return false;
+		}
+		content_length = content_length * 10 + (*value - '0');
+	}
+	if(request->has_content_length && request->content_length != content_length) {
+		return false;
+	}
+	request->has_content_length = true;
+	request->content_length = content_length;
+	return true;
+}
+
+/**
+ * @brief parses a header line of a request
+ * @details the name has to be followed by a colon without whitespace in between, the whitespace around the value
+ *          is not part of it.
+ * @param request the request
+ * @param buffer the buffer
+ * @param line the start of the line
+ * @param end the end of the line without the line break
+ * @return true on success, false if the line is malformed
+ */
+static bool parse_header_line(http_request_t *request, const char *buffer, const char *line, const char *end) {
+	const char *colon = memchr(line, ':', end - line);
+	if(colon == NULL || colon == line || memchr(line, ' ', colon - line) != NULL ||
+			memchr(line, '\t', colon - line) != NULL) {
+		return false;
+	}
+	const char *value = colon + 1;
+	while(value < end && (*value == ' ' || *value == '\t')) {
+		value++;
+	}
+	while(end > value && (end[-1] == ' ' || end[-1] == '\t')) {
+		end--;
+	}
+	http_header_t *header = &request->headers[request->header_count++];
+	header->name = make_slice(buffer, line, colon);
+	header->value = make_slice(buffer, value, end);
+	if(slice_equals_ignore_case(buffer, header->name, "Content-Length")) {
+		return parse_content_length(request, value, end);
+	}
+	if(slice_equals_ignore_case(buffer, header->name, "Transfer-Encoding")) {
+		request->has_transfer_encoding = true;
+	}
+	return true;
+}
+
+parse_result_t parse_request(http_request_t *request, const char *buffer, size_t length) {
+	if(request->length != 0) {
+		return PARSE_COMPLETE;
+	}
+	while(request->parsed < length) {
+		const char *line = buffer + request->parsed;
+		const char *newline = memchr(line, '\n', length - request->parsed);
+		if(newline == NULL) {
+			return PARSE_INCOMPLETE;
+		}
+		const char *end = newline > line && newline[-1] == '\r' ? newline - 1 : newline;
+		request->parsed = newline + 1 - buffer;
+		if(!request->request_line_parsed) {
+			if(end == line) {
+				continue;
+			}
+			if(!parse_request_line(request, buffer, line, end)) {
+				return PARSE_MALFORMED;
+			}
+			request->request_line_parsed = true;
+			continue;
+		}
+		if(end == line) {
+			request->length = request->parsed;
+			return PARSE_COMPLETE;
+		}
+		//a line that starts with whitespace continues the previous header, which is obsolete
+		if(*line == ' ' || *line == '\t') {
+			return PARSE_MALFORMED;
+		}
+		if(request->header_count == MAX_HEADERS) {
+			return PARSE_TOO_LARGE;
+		}
+		if(!parse_header_line(request, buffer, line, end)) {
+			return PARSE_MALFORMED;
+		}
+	}
+	return PARSE_INCOMPLETE;
+}
+
+const http_header_t* find_header(const http_request_t *request, const char *buffer, const char *name,
+		const http_header_t *previous) {
+	const http_header_t *header = previous != NULL ? previous + 1 : request->headers;
+	for(; header < request->headers + request->header_count; header++) {
+		if(slice_equals_ignore_case(buffer, header->name, name)) {
+			return header;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief parses the value of a q parameter
+ * @details a value that is not a valid quality counts as 0.
+ * @param value the start of the value
+ * @param end the end of the header value
+ * @return the quality between 0 and 1
+ */
+static double parse_quality(const char *value, const char *end) {
+	if(value == end || (*value != '0' && *value != '1')) {
+		return 0;
+	}
+	double quality = *value++ - '0';
+	if(value < end && *value == '.') {
+		double scale = 0.1;
+		for(value++; value < end && *value >= '0' && *value <= '9' && scale > 0.0001; value++) {
+			quality += (*value - '0') * scale;
+			scale /= 10;
+		}
+	}
+	return quality > 1 ? 1 : quality;
+}
+
+double get_option_quality(const http_request_t *request, const char *buffer, const char *name, const char *option) {
+	size_t option_length = strlen(option);
+	const http_header_t *header = find_header(request, buffer, name, NULL);
+	for(; header != NULL; header = find_header(request, buffer, name, header)) {
+		const char *current = buffer + header->value.offset;
+		const char *end = current + header->value.length;
+		while(current < end) {
+			while(current < end && (*current == ' ' || *current == '\t' || *current == ',')) {
+				current++;
+			}
+			const char *token = current;
+			while(current < end && *current != ' ' && *current != '\t' && *current != ',' && *current != ';') {
+				current++;
+			}
+			bool matches = (size_t)(current - token) == option_length && strncasecmp(token, option, option_length) == 0;
+			double quality = 1;
+			while(current < end && (*current == ' ' || *current == '\t')) {
+				current++;
+			}
+			while(current < end && *current == ';') {
+				current++;
+				while(current < end && (*current == ' ' || *current == '\t')) {
+					current++;
+				}
+				if(end - current >= 2 && (*current == 'q' || *current == 'Q') && current[1] == '=') {
+					quality = parse_quality(current + 2, end);
+				}
+				while(current < end && *current != ';' && *current != ',') {
+					current++;
+				}
+			}
+			if(matches) {
+				return quality;
+			}
+		}
+	}
+	return -1;
+}
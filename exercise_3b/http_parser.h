@@ -0,0 +1,123 @@
+/**
+ * @file
+ * @brief http_parser module parses the request line and the headers of http requests incrementally
+ *
+ * @author Benjamin Deutsch (12215881)
+ * @date 23.12.2023
+ */
+#ifndef HTTP_PARSER_H
+#define HTTP_PARSER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MAX_HEADERS 64 //the maximum number of headers of a request
+
+/**
+ * @brief a part of the buffer a request is parsed from
+ * @details slices never copy the bytes they describe, they are only valid as long as the buffer is not modified.
+ */
+typedef struct http_slice {
+	uint32_t offset;
+	uint32_t length;
+} http_slice_t;
+
+/**
+ * @brief a header of a request
+ * @details the value does not contain the whitespace around it.
+ */
+typedef struct http_header {
+	http_slice_t name;
+	http_slice_t value;
+} http_header_t;
+
+/**
+ * @brief the result of parsing a request
+ * @details PARSE_TOO_LARGE is returned if the request has more than MAX_HEADERS headers.
+ */
+typedef enum parse_result {
+	PARSE_INCOMPLETE,
+	PARSE_COMPLETE,
+	PARSE_MALFORMED,
+	PARSE_TOO_LARGE
+} parse_result_t;
+
+/**
+ * @brief the parsed request line and headers of a request
+ * @details parsed is the number of bytes that were parsed so far, which always ends at the end of a line, so
+ *          parsing continues after a partial read without scanning a byte twice. length is the number of bytes of
+ *          the request line and the headers including the empty line that ends them, it is only set once the request
+ *          is complete. content_length is the value of the Content-Length header, 0 if the request has none, and
+ *          has_transfer_encoding is true if the request has a Transfer-Encoding header, so the length of its body
+ *          is unknown.
+ */
+typedef struct http_request {
+	size_t parsed;
+	bool request_line_parsed;
+	http_slice_t method;
+	http_slice_t path;
+	http_slice_t version;
+	http_header_t headers[MAX_HEADERS];
+	size_t header_count;
+	bool has_content_length;
+	unsigned long content_length;
+	bool has_transfer_encoding;
+	size_t length;
+} http_request_t;
+
+/**
+ * @brief prepares the given request for parsing a new request
+ * @param request the request
+ */
+void reset_request_parser(http_request_t *request);
+
+/**
+ * @brief parses the lines of the given buffer that were not parsed yet
+ * @details lines end with CRLF or a single LF. Empty lines before the request line are ignored, headers that are
+ *          continued on the next line, a Content-Length that is not a number and Content-Length headers with
+ *          different values are malformed. Only the bytes up to the end of the headers are parsed, so the buffer
+ *          may contain the body or pipelined requests after them.
+ * @param request the request, it keeps the state between calls
+ * @param buffer the buffer, its first bytes have to be the same as in the previous calls
+ * @param length the number of bytes in the buffer
+ * @return PARSE_COMPLETE once the empty line after the headers was parsed, PARSE_INCOMPLETE if more bytes are
+ *         needed, PARSE_MALFORMED or PARSE_TOO_LARGE if the request cannot be parsed
+ */
+parse_result_t parse_request(http_request_t *request, const char *buffer, size_t length);
+
+/**
+ * @brief returns whether the given slice equals the given string
+ * @param buffer the buffer of the slice
+ * @param slice the slice
+ * @param string the string, terminated by a null byte
+ * @return true if the slice equals the string, false otherwise
+ */
+bool slice_equals(const char *buffer, http_slice_t slice, const char *string);
+
+/**
+ * @brief returns the next header with the given name
+ * @details header names are compared case-insensitively.
+ * @param request the request
+ * @param buffer the buffer the request was parsed from
+ * @param name the name of the header
+ * @param previous the header after which the search starts, NULL to start at the first header
+ * @return the header or NULL if there is no such header
+ */
+const http_header_t* find_header(const http_request_t *request, const char *buffer, const char *name,
+		const http_header_t *previous);
+
+/**
+ * @brief returns the quality the headers of the given request assign to the given option
+ * @details all headers with the given name are searched and options are compared case-insensitively. A header may
+ *          list several options separated by commas, each optionally followed by parameters. The quality is the q
+ *          parameter of the option, parameters other than q are ignored.
+ * @param request the request
+ * @param buffer the buffer the request was parsed from
+ * @param name the name of the header
+ * @param option the option
+ * @return the quality of the option between 0 and 1, 1 if it has no q parameter, or -1 if it is not listed
+ */
+double get_option_quality(const http_request_t *request, const char *buffer, const char *name, const char *option);
+
+#endif /* HTTP_PARSER_H */
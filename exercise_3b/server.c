@@ -5,12 +5,15 @@
  * @author Benjamin Deutsch (12215881)
  * @date 23.12.2023
  */
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/eventfd.h>
 #include <netinet/in.h>
 #include <string.h>
 #include <limits.h>
@@ -18,37 +21,70 @@
 #include <netdb.h>
 #include <signal.h>
 #include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include "event_loop.h"
+#include "file_cache.h"
 
-static bool quit = false;
-static bool waiting = true;
-static int sockfd = -1;
+#define MAX_WORKERS 1024 //the maximum number of worker threads
 
 /**
- * @brief closes the socket file descriptor if it is open
+ * @brief a worker thread that serves the connections of its own listening socket with its own event loop
+ * @details cpu is the cpu the thread is pinned to, or -1 if it is not pinned.
+ */
+typedef struct worker {
+	pthread_t thread;
+	int listen_fd;
+	int cpu;
+	const server_config_t *config;
+	int result;
+} worker_t;
+
+static int quit_fd = -1;
+static worker_t *workers = NULL;
+static long worker_count = 0;
+
+/**
+ * @brief closes the listening sockets and the quit descriptor if they are open
  */
 static void cleanup(void) {
-	if(sockfd != -1) {
-		close(sockfd);
+	long i;
+	for(i = 0; i < worker_count; i++) {
+		if(workers[i].listen_fd != -1) {
+			close(workers[i].listen_fd);
+		}
 	}
+	free(workers);
+	workers = NULL;
+	worker_count = 0;
+	if(quit_fd != -1) {
+		close(quit_fd);
+	}
+}
+
+/**
+ * @brief makes the quit descriptor readable, which stops all event loops
+ * @details only calls write, so it can be used in a signal handler.
+ */
+static void request_quit(void) {
+	uint64_t one = 1;
+	ssize_t written = write(quit_fd, &one, sizeof(one));
+	(void)written;
 }
 
 /**
- * @brief handles a signal by setting the quit flag to true
+ * @brief handles a signal by stopping all event loops
  * @param signal the signal
  */
 static void handle_signal(int signal) {
-	if(waiting) {
-		cleanup();
-		exit(EXIT_SUCCESS);	
-	}
-	quit = true;
+	request_quit();
 }
 
 /**
  * @brief prints the usage message for the http server to stdout and exits the programm with EXIT_FAILURE
  */
 static void exit_with_usage_message(void) {
-	printf("SYNOPSIS: client [-p PORT] [ -o FILE | -d DIR ] URL\n");
+	printf("SYNOPSIS: server [-p PORT] [-i INDEX] [-w WORKERS] [-c CACHE_BYTES] [-z] DOC_ROOT\n");
 	exit(EXIT_FAILURE);
 }
 
@@ -73,154 +109,111 @@ static void exit_with_error_message(char *programm_name, char *msg) {
 }
 
 /**
- * @brief returns the value of the Content-Length header
- * @details returns the value of the Content-Length header. If the header is not found or the value of the header is not a number, 0 is returned.
- * @param headers the http headers
- * @return the value of the Content-Length header
+ * @brief creates a listening socket for the given port
+ * @details if reuse_port is true, SO_REUSEPORT is set, so that several sockets can listen on the same port and
+ *          the kernel distributes the incoming connections between them.
+ * @param programm_name the name of the programm (argv[0])
+ * @param port the port
+ * @param reuse_port whether the port is shared with other sockets
+ * @return the socket, the programm exits if it could not be created
  */
-unsigned long get_content_length(const char *headers) {
-	const char *search_str = "Content-Length: ";
-	const size_t search_str_len = strlen(search_str);
-
-	const char *start = strstr(headers, search_str);
-	if (start == NULL) {
-		return 0;  // Content-Length header not found
+static int create_listening_socket(char *programm_name, long port, bool reuse_port) {
+	int sockfd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(sockfd < 0) {
+		exit_with_error_message(programm_name, "Socket error");
 	}
-
-	start += search_str_len;
-	char *endptr;
-	unsigned long length = strtoul(start, &endptr, 10);
-	if (start == endptr) {
-		return 0;
+	
+	int reuse = 1;
+	if(setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0 ||
+			(reuse_port && setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) < 0)) {
+		close(sockfd);
+		exit_with_error_message(programm_name, "Setsockopt error");
 	}
-
-	return length;
+	
+	struct sockaddr_in sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_port = htons(port);
+	sa.sin_addr.s_addr = INADDR_ANY;
+	if (bind(sockfd, (struct sockaddr *)&sa, sizeof(struct sockaddr_in)) < 0) {
+		close(sockfd);
+		exit_with_error_message(programm_name, "Bind error");
+	}
+	
+	if (listen(sockfd, SOMAXCONN) < 0) {
+		close(sockfd);
+		exit_with_error_message(programm_name, "Listen error");
+	}
+	return sockfd;
 }
 
 /**
- * @brief reads the content of a file and returns it as a string
- * @param programm_name the name of the programm (argv[0])
- * @param file the file whose content should be read
- * @param stopAtEmptyLine if true, then this function stops reading as soon as a an empty line ("\r\n") is encountered
- * @return the file content as a string
+ * @brief pins the calling worker thread to its cpu and runs its event loop
+ * @details if the event loop fails, all other workers are stopped, too.
+ * @param arg the worker_t of the thread
+ * @return NULL
  */
-static char* read_file_content(char *programm_name, FILE *file, bool stopAtEmptyLine) {
-	size_t size = 1024;
-	char buff[size];
-	char *content = malloc(size);
-	if(content == NULL){
-		error_message(programm_name,"memory allocation error");
-		return NULL;
+static void* run_worker(void *arg) {
+	worker_t *worker = arg;
+	if(worker->cpu != -1) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(worker->cpu, &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
 	}
-	content[0] = '\0';
-	while (fgets(buff, sizeof(buff), file) != NULL){
-		if(size < strlen(content) + strlen(buff) + 1) {
-			size = size * 2;
-			char *reallocated = realloc(content, size);
-			if(reallocated == NULL) {
-				error_message(programm_name,"memory allocation error");
-				free(content);
-				return NULL;
-			}
-			content = reallocated;
-		}
-		strcat(content,buff);
-		if(stopAtEmptyLine && strcmp(buff, "\r\n") == 0) {
-			break;
-		}
+	worker->result = run_event_loop(worker->listen_fd, quit_fd, worker->config);
+	if(worker->result < 0) {
+		request_quit();
 	}
-	return content;
+	return NULL;
 }
 
 /**
- * @brief sends a http response
- * @details writes an http response with the given status, status message and content to the given file. The file is closed after this function executed.
- * @param connfile the file to which the response should be written to
- * @param programm_name the name of the programm (argv[0])
- * @param status the response status
- * @param status_message the response status message
- * @param content the content of the response
- * @return true if the response has been written to the file successfully, false otherwise
+ * @brief serves the files of a directory over http
+ * @details the server runs the given number of worker threads. Every worker has its own listening socket on the
+ *          port (SO_REUSEPORT) and its own epoll event loop and is pinned to its own cpu, wrapping around if there
+ *          are more workers than cpus. The only state the workers share while they serve requests is the file cache,
+ *          which they access under its read-write lock.
+ * @param argc the number of arguments
+ * @param argv can contain the following arguments:
+ *             -p [int]: the port, 8080 by default
+ *             -i [str]: the file that is served for the path /, /index.html by default
+ *             -w [int]: the number of worker threads, 1 by default
+ *             -c [int]: the number of bytes the workers may use to cache file contents, DEFAULT_CACHE_BUDGET by
+ *                       default, 0 disables the cache
+ *             -z:       compresses files with gzip for clients that accept it, the compressed files are kept in
+ *                       the cache. Files larger than MAX_COMPRESSED_FILE_SIZE are sent uncompressed
+ *             the last argument is DOC_ROOT, the directory whose files are served
+ * @return EXIT_SUCCESS if the programm executed successfully, EXIT_FAILURE otherwise
  */
-static bool send_response(FILE *connfile, char *programm_name, char *status, char *status_message, char *content) {
-	bool statusIs200 = false;
-	if(strcmp(status, "200") == 0) {
-		statusIs200 = true;
-	}
-	char *http_str = "HTTP/1.1 ";
-	char *connection_str = "Connection: close\r\n\r\n";
-	char *content_length_label_str = "Content-Length: ";
-	char content_length_str[30];
-	snprintf(content_length_str, sizeof(content_length_str), "%ld", strlen(content)); 
-	char *date_label_str = "Date: ";
-	// Get the current time
-	time_t current_time;
-	struct tm *local_time;
-	char date_str[80];
-	current_time = time(NULL);
-	local_time = localtime(&current_time);
-	strftime(date_str, sizeof(date_str), "%a, %d %b %y %H:%M:%S %Z", local_time);
-	
-	char response[strlen(http_str) + strlen(status) + strlen(status_message) + 3 + strlen(date_label_str) + strlen(date_str) + 2 + strlen(content_length_label_str) + strlen(content_length_str) + 2 + strlen(connection_str) + strlen(content) + 20];
-	
-	response[0] = '\0';
-	strcat(response, http_str);
-	strcat(response, status);
-	strcat(response, " ");
-	strcat(response, status_message);
-	strcat(response, "\r\n");
-	if(statusIs200) {
-		strcat(response, date_label_str);
-		strcat(response, date_str);
-		strcat(response, "\r\n");
-		strcat(response, content_length_label_str);
-		strcat(response, content_length_str);
-		strcat(response, "\r\n");
-	}
-	strcat(response, connection_str);
-	strcat(response, content);
-	strcat(response, "\r\n\r\n");
-	
-	if(fputs(response, connfile) == EOF) {
-		error_message(programm_name, "fputs response error");
-		fclose(connfile);
-		return false;
-	}
-	
-	if(fflush(connfile) == EOF) {
-		perror("fflush");
-		error_message(programm_name, "fflush response error");
-		fclose(connfile);
-		return false;
+int main(int argc, char *argv[]) {
+	//the quit descriptor has to exist before a signal can arrive
+	quit_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if(quit_fd < 0) {
+		fprintf(stderr, "%s: %s\n", argv[0], "Eventfd error");
+		exit(EXIT_FAILURE);
 	}
 	
-	if(fclose(connfile) == EOF) {
-		error_message(programm_name, "fclose response error");
-		return false;
-	}
-	return true;
-}
-
-int main(int argc, char *argv[]) {
 	//add signal handlers
 	struct sigaction siga;
 	memset(&siga, 0, sizeof(siga));
 	siga.sa_handler = handle_signal;
 	sigaction(SIGINT, &siga, NULL);
 	sigaction(SIGTERM, &siga, NULL);
+	signal(SIGPIPE, SIG_IGN);
 
 	//get the programm arguments
 	char *programm_name = argv[0], *index_filename = "/index.html", *doc_root;
-	long port = 8080;
-	bool port_flag = false, index_filename_flag = false;
+	long port = 8080, count = 1, cache_budget = DEFAULT_CACHE_BUDGET;
+	bool port_flag = false, index_filename_flag = false, worker_flag = false, cache_flag = false, compress = false;
 	int c;
-	while((c = getopt(argc, argv, "p:i:")) != -1) {
+	char *endptr;
+	while((c = getopt(argc, argv, "p:i:w:c:z")) != -1) {
 		switch(c){
 			case 'p':
 				if(port_flag) {
 					exit_with_error_message(programm_name,"Invalid options");
 				}
-				char *endptr;
 				port = strtol(optarg, &endptr, 10);
 				
 				if((errno == ERANGE && (port == LONG_MAX || port == LONG_MIN)) || 
@@ -239,6 +232,33 @@ int main(int argc, char *argv[]) {
 				index_filename_flag = true;
 				index_filename = optarg;
 				break;
+			case 'w':
+				if(worker_flag) {
+					exit_with_error_message(programm_name, "Invalid options");
+				}
+				count = strtol(optarg, &endptr, 10);
+				if(count < 1 || count > MAX_WORKERS || *endptr != '\0') {
+					exit_with_error_message(programm_name, "Invalid number of workers");
+				}
+				worker_flag = true;
+				break;
+			case 'c':
+				if(cache_flag) {
+					exit_with_error_message(programm_name, "Invalid options");
+				}
+				errno = 0;
+				cache_budget = strtol(optarg, &endptr, 10);
+				if(errno != 0 || cache_budget < 0 || *endptr != '\0') {
+					exit_with_error_message(programm_name, "Invalid cache size");
+				}
+				cache_flag = true;
+				break;
+			case 'z':
+				if(compress) {
+					exit_with_error_message(programm_name, "Invalid options");
+				}
+				compress = true;
+				break;
 			default:
 				exit_with_error_message(programm_name, "Invalid options");
 		}
@@ -247,93 +267,74 @@ int main(int argc, char *argv[]) {
 	if(argc - optind != 1) {
 		exit_with_usage_message();
 	}
+	if(compress && cache_budget == 0) {
+		exit_with_error_message(programm_name, "Compression needs the cache");
+	}
 	doc_root = argv[optind];	
 	
-	//create socket
-	sockfd = socket(AF_INET, SOCK_STREAM, 0);
-	if(sockfd < 0) {
-		exit_with_error_message(programm_name, "Socket error");
+	server_config_t config;
+	config.programm_name = programm_name;
+	config.doc_root = doc_root;
+	config.index_filename = index_filename;
+	config.cache = NULL;
+	config.compress = compress;
+	if(cache_budget > 0) {
+		config.cache = create_file_cache(cache_budget);
+		if(config.cache == NULL) {
+			exit_with_error_message(programm_name, "memory allocation error");
+		}
 	}
 	
-	struct sockaddr_in sa;
-	memset(&sa, 0, sizeof(sa));
-	sa.sin_family = AF_INET;
-	sa.sin_port = htons(port);
-	sa.sin_addr.s_addr = INADDR_ANY;
-	if (bind(sockfd, (struct sockaddr *)&sa, sizeof(struct sockaddr_in)) < 0) {
-		exit_with_error_message(programm_name, "Bind error");
+	//the sockets of all workers are created before any of them starts, so a bind error stops the server early
+	workers = malloc(count * sizeof(worker_t));
+	if(workers == NULL) {
+		exit_with_error_message(programm_name, "memory allocation error");
 	}
-	
-	if (listen(sockfd, 1) < 0) {
-		exit_with_error_message(programm_name, "Listen error");
+	cpu_set_t allowed;
+	bool pin = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+	int cpu = -1;
+	long i;
+	for(i = 0; i < count; i++) {
+		worker_t *worker = &workers[i];
+		worker->listen_fd = -1;
+		worker_count++;
+		worker->listen_fd = create_listening_socket(programm_name, port, count > 1);
+		worker->config = &config;
+		worker->result = 0;
+		worker->cpu = -1;
+		if(pin) {
+			//the next allowed cpu after the one of the previous worker
+			do {
+				cpu = (cpu + 1) % CPU_SETSIZE;
+			} while(!CPU_ISSET(cpu, &allowed));
+			worker->cpu = cpu;
+		}
 	}
 	
-	while(!quit) {
-		waiting = true;
-		int connfd = accept(sockfd, NULL, NULL);
-		waiting = false;
-		if(connfd < 0) {
-			exit_with_error_message(programm_name, "Accept error");
-		}
-		FILE *connfile = fdopen(connfd, "r+");
-		if(connfile == NULL) {
-			exit_with_error_message(programm_name, "Fdopen error");
-		}
-		
-		char *request = read_file_content(programm_name, connfile, true);
-		if(request == NULL) {
-			fclose(connfile);
-			exit_with_error_message(programm_name, "read request error");
-		}
-		
-		unsigned long content_length = get_content_length(request);
-		unsigned long i;
-		for(i = 0; i < content_length; i++) {
-			fgetc(connfile);
-		}
-		
-		char *http_method = strtok(request, " ");
-		char *request_path = strtok(NULL, " ");
-		char *http_token = strtok(NULL, "\r\n");
-		if(http_method == NULL || request_path  == NULL || http_token == NULL || strcmp(http_token, "HTTP/1.1") != 0) {
-			free(request);
-			send_response(connfile, programm_name, "400", "(Bad Request)", "");
-			continue;
-		}
-		if(strcmp(http_method, "GET") != 0) {
-			free(request);
-			send_response(connfile, programm_name, "501", "(Not Implemented)", "");
-			continue;
-		}
-		if(strcmp(request_path, "/") == 0) {
-			request_path = index_filename;
-		}
-		
-		//open file
-		char full_file_path[strlen(doc_root) + strlen(request_path) + 4];
-		full_file_path[0] = '\0';
-		strcat(full_file_path, "./");
-		strcat(full_file_path, doc_root);
-		if(request_path[0] != '/') {
-			strcat(full_file_path, "/");
-		}
-		strcat(full_file_path, request_path);
-		free(request);
-		
-		FILE *response_file = fopen(full_file_path, "r");
-		if(response_file == NULL) {
-			send_response(connfile, programm_name, "404", "(Not Found)", "");
-			continue;
-		}
-		
-		char *response_content = read_file_content(programm_name, response_file, false);
-		if(response_content == NULL) {
-			send_response(connfile, programm_name, "404", "(Not Found)", "");
-		}else{
-			send_response(connfile, programm_name, "200", "OK", response_content);
-			free(response_content);
+	//the first worker runs in the main thread
+	long started;
+	for(started = 1; started < count; started++) {
+		if(pthread_create(&workers[started].thread, NULL, run_worker, &workers[started]) != 0) {
+			error_message(programm_name, "Thread creation error");
+			request_quit();
+			break;
 		}
-		fclose(response_file);
+	}
+	bool error = false;
+	if(started == count) {
+		run_worker(&workers[0]);
+		error = workers[0].result < 0;
+	}
+	for(i = 1; i < started; i++) {
+		pthread_join(workers[i].thread, NULL);
+		error = error || workers[i].result < 0;
+	}
+	if(config.cache != NULL) {
+		free_file_cache(config.cache);
+	}
+	if(error) {
+		exit_with_error_message(programm_name, "Event loop error");
 	}
 	cleanup();
+	return EXIT_SUCCESS;
 }